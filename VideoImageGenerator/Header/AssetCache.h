@@ -0,0 +1,65 @@
+#pragma once
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Image.h"
+
+//A decoded image and the state of the file it came from so we can tell when the file has changed
+struct CachedAsset
+{
+	std::shared_ptr<Image> StoredImage;
+	long long LastWriteTime = 0;
+	unsigned long long FileSize = 0;
+	size_t DataSize = 0;
+
+	//Resized images are kept for the image they were made from, once that image is gone the resized image can't be used anymore
+	//since a new image could get the same address
+	std::weak_ptr<Image> SourceImage;
+	std::list<std::string>::iterator UsageIterator;
+};
+
+//Keeps the images loaded from disk so a file used by many images only gets decoded once for the whole process.
+//The images are shared between every user so they must never be changed, copy them first when they need to be altered
+class AssetCache
+{
+public:
+	//Returns the image at the path in the given format, it will be loaded if it isn't in the cache or the file changed since it was loaded.
+	//With bTrim the transparent margins are cut off when it is loaded, which is cached separately from the untrimmed image
+	static std::shared_ptr<Image> GetImage(const std::string& filename, const PixelFormat& format = PixelFormat::FormatFloat, const bool& bTrim = false);
+
+	//Returns the source image resized to the size of a block, or nullptr if it hasn't been resized to that size yet
+	static std::shared_ptr<Image> FindResizedImage(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio);
+	static void AddResizedImage(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio, const std::shared_ptr<Image>& resizedImage);
+
+	//When the decoded images take up more memory than the budget the least recently used ones are removed from the cache
+	static void SetMemoryBudget(const size_t& bytes);
+	static size_t GetMemoryBudget();
+	static size_t GetMemoryUsed();
+
+	static void Clear();
+	static long long GetHits();
+	static long long GetMisses();
+	static long long GetResizeHits();
+	static long long GetResizeMisses();
+
+private:
+	static void EvictToBudget();
+	static void AddAsset(const std::string& key, CachedAsset& asset);
+	static void RemoveAsset(const std::unordered_map<std::string, CachedAsset>::iterator& asset);
+	static std::string MakeResizeKey(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio);
+
+	static std::unordered_map<std::string, CachedAsset> Assets;
+
+	//Both the decoded and the resized images are stored here and share the memory budget.
+	//The front is the most recently used key and the back the least recently used one
+	static std::list<std::string> UsageOrder;
+	static std::mutex AssetMutex;
+
+	static size_t MemoryBudget;
+	static size_t MemoryUsed;
+	static long long Hits;
+	static long long Misses;
+	static long long ResizeHits;
+	static long long ResizeMisses;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
 #include "Image.h"
 #include "Font.h"
 #include "../Library/json/json.hpp"
@@ -52,8 +53,28 @@ private:
 	nlohmann::json LayoutJData;
 };
 
+class BaseBlock;
+
+//A block with its position resolved for the current image, the RenderPlan is a list of these in the order they have to be drawn
+struct RenderItem
+{
+	std::shared_ptr<BaseBlock> Block;
+
+	//The topleft corner where the data of the block is drawn and the size of that data
+	int WidthOffset = 0;
+	int HeightOffset = 0;
+	int Width = 0;
+	int Height = 0;
+
+	//The bottom of the block used to find the lowest block in the layout, like CalculateBottomHeight this doesn't include the block's own snap correction
+	int BottomHeight = 0;
+
+	//Whether the block has any data to draw
+	bool bDraw = false;
+};
+
 //The BaseBlock which is used for everything in the Layout
-class BaseBlock
+class BaseBlock : public std::enable_shared_from_this<BaseBlock>
 {
 public:
 	BaseBlock(const std::string& name, const int& widthOffset = 0, const int& heightOffset = 0, const int& width = 0, const int& height = 0, const Alignment& blockAlignment = Alignment::Left, const SnapAlignment& snapSide = SnapAlignment::NoSnap);
@@ -63,8 +84,14 @@ public:
 	void AddBlock(const std::shared_ptr<BaseBlock> newBlock);
 	void AddPotentialLayout(const std::shared_ptr<PotentialLayout> newLayout);
 
-	//Virtual functions used Save and ClearData which will be called in every child
-	virtual void SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font);
+	//Goes through this block and every block after it once and adds them to the plan with their position for the current image.
+	//The offsets are the total offset of the previous blocks so they don't have to be calculated again for every block
+	void CompileRenderPlan(std::vector<RenderItem>& plan, const std::shared_ptr<Font>& font, const int& previousWidthOffset = 0, const int& previousHeightOffset = 0);
+
+	//Virtual functions used to prepare and draw the data and ClearData which will be called in every child.
+	//PrepareData returns whether there is anything to draw
+	virtual bool PrepareData(const std::shared_ptr<Font>& font);
+	virtual void DrawData(const std::shared_ptr<Image>& image, const int& widthOffset, const int& heightOffset);
 	virtual void ClearData();
 
 	//Functions for finding the position of a specific side of the Block
@@ -93,6 +120,8 @@ public:
 	const std::vector<std::shared_ptr<PotentialLayout>>& GetPotentialLayouts() { return PotentialLayouts; };
 	const std::vector<std::shared_ptr<BaseBlock>>& GetLinkedBlocks() { return LinkedBlocks; };
 	void SetPreviousBlock(const std::shared_ptr<BaseBlock> value) { PreviousBlock = value; };
+	void SetStatic(const bool value) { bStatic = value; };
+	bool IsStatic() const { return bStatic; };
 
 protected:
 	//Functions that will backpropagate through the Blocks to calculate the Blocks current offset
@@ -124,6 +153,9 @@ protected:
 	//If the block was created using a PotentialLayout it shouldn't remain for the next image
 	bool bCreatedThroughPossibleLayout = false;
 
+	//A static block has the same data and position in every image so it has already been drawn into the static layer of the Layout
+	bool bStatic = false;
+
 	//When snapping to a side it will pick the side of the previous block
 	SnapAlignment SnapSide = SnapAlignment::NoSnap;
 
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//A queue between two stages of a pipeline. Push waits while the queue is full and Pop waits while it is empty so a stage can never get
+//more than the capacity ahead of the next one, which also caps the memory used by the items in between.
+//Once the queue is closed Push fails and Pop returns the items that are left before it fails as well
+template<typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(const size_t& capacity) : Capacity(std::max<size_t>(1, capacity)) {}
+
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> Lock(QueueMutex);
+		NotFull.wait(Lock, [this]() { return bClosed || Items.size() < Capacity; });
+		if (bClosed)
+		{
+			return false;
+		}
+
+		Items.push_back(std::move(item));
+		NotEmpty.notify_one();
+		return true;
+	}
+
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> Lock(QueueMutex);
+		NotEmpty.wait(Lock, [this]() { return bClosed || !Items.empty(); });
+		if (Items.empty())
+		{
+			return false;
+		}
+
+		item = std::move(Items.front());
+		Items.pop_front();
+		NotFull.notify_one();
+		return true;
+	}
+
+	//Wakes up every stage that is waiting, called by the producer when it has nothing left to push
+	void Close()
+	{
+		std::lock_guard<std::mutex> Lock(QueueMutex);
+		bClosed = true;
+		NotFull.notify_all();
+		NotEmpty.notify_all();
+	}
+
+	size_t GetCapacity() { return Capacity; }
+
+private:
+	size_t Capacity;
+	bool bClosed = false;
+	std::deque<T> Items;
+	std::mutex QueueMutex;
+	std::condition_variable NotFull;
+	std::condition_variable NotEmpty;
+};
@@ -1,39 +1,139 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <iostream>
-#include <map>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <vector>
 #include "Image.h"
-#include "../library/stb/stb_truetype.h"
+#include "MappedFile.h"
+#include "../Library/stb/stb_truetype.h"
 
-struct CharacterInfo 
+//A character of a shaped string, the glyph of the font that draws it and where it starts on the line
+struct ShapedGlyph
 {
-	int CharacterWidth = 0;
-	int LeftSideOffset = 0;
+	int Codepoint = 0;
+	int GlyphIndex = 0;
+	int XOffset = 0;
+};
+
+//The glyph of the font for a character and how far the pen moves after it in font units
+struct GlyphMetrics
+{
+	int GlyphIndex = 0;
+	int Advance = 0;
+};
+
+//A string laid out at one pixel height, measuring and drawing both use it so the advances and kerning are only added up once
+struct ShapedText
+{
+	std::vector<ShapedGlyph> Glyphs;
+	int Width = 0;
+};
+
+//A rasterized character, the Coverage is 1 byte per pixel and the offsets are where the bitmap starts relative to the pen position on the baseline
+struct GlyphBitmap
+{
+	std::shared_ptr<unsigned char> Coverage;
+	int Width = 0;
+	int Height = 0;
+	int LeftOffset = 0;
+	int TopOffset = 0;
+};
+
+//A string rendered in one color and format, the image is shared by every block that shows the same text so it must never be changed
+struct TextRun
+{
+	std::shared_ptr<Image> RunImage;
+	size_t DataSize = 0;
+	std::list<std::string>::iterator UsageIterator;
 };
 
 class Font
 {
 public:
-	Font(const std::string& filePath);
+	//With bSignedDistanceField every character is rasterized once as a signed distance field which is scaled to every pixel height,
+	//so the glyph cache doesn't grow with the amount of pixel heights. The edges are a bit softer than rasterizing every height
+	Font(const std::string& filePath, const bool& bSignedDistanceField = false);
 	~Font();
 
 	//Getters
 	std::shared_ptr<Image> GetTextImage(const std::string& text, const int& characterPixelHeight);
 	std::shared_ptr<Image> GetCharacterImage(const char* text, const int& characterPixelHeight);
 	int GetStringLength(const std::string& text, const int& characterPixelHeight);
+	ShapedText ShapeText(const std::string& text, const int& characterPixelHeight);
+	std::shared_ptr<GlyphBitmap> GetGlyphBitmap(const int& codepoint, const int& characterPixelHeight);
+	long long GetGlyphCacheHits() { return GlyphCacheHits; }
+	long long GetGlyphCacheMisses() { return GlyphCacheMisses; }
+	bool IsSignedDistanceField() { return bSDF; }
+
+	//Draws the shaped text in the color straight onto the image with the top left of the text at the offsets, the color is not premultiplied.
+	//Only the pixels of the characters are blended and they are cut off at the edges of the text the same way they are on a text image
+	void DrawShapedText(const std::shared_ptr<Image>& image, const ShapedText& shaped, const int& characterPixelHeight, const Pixel& color, const int& widthOffset = 0, const int& heightOffset = 0);
+
+	//Returns the text rendered in the color and converted to the format, the width of the image is the measured width of the text.
+	//Without a color the text stays white. A run is only rendered the first time it is asked for until it gets evicted,
+	//with bRepeatedOnly it returns nullptr the first time instead so text that is only used once can be drawn with DrawShapedText
+	std::shared_ptr<Image> GetTextRunImage(const std::string& text, const int& characterPixelHeight, const std::shared_ptr<Pixel>& color, const PixelFormat& format,
+		const bool& bRepeatedOnly = false);
+	void SetTextRunBudget(const size_t& bytes);
+	size_t GetTextRunMemoryUsed();
+	long long GetTextRunHits() { return TextRunHits; }
+	long long GetTextRunMisses() { return TextRunMisses; }
 
 private:
 	void Init(const std::string& filePath);
-	void MakeCharacterWidthMap();
+	void MakeMetricTables();
+	GlyphMetrics MakeGlyphMetrics(const int& codepoint);
+	const GlyphMetrics& GetGlyphMetrics(const int& codepoint);
+	int GetKerning(const int& leftCodepoint, const int& rightCodepoint);
 	float GetScale(const int& characterPixelHeight);
+	std::shared_ptr<GlyphBitmap> GetGlyphField(const int& codepoint);
+	std::shared_ptr<GlyphBitmap> MakeGlyphFromField(const int& codepoint, const int& characterPixelHeight);
 
-	//The FontInfo and the Buffer where the font will be loaded into
+	//The FontInfo and the file the font is read from, which has to stay mapped as long as the Info is used
 	stbtt_fontinfo Info;
-	std::shared_ptr<unsigned char> Buffer;
+	std::shared_ptr<MappedFile> FontFile;
+	bool bLoaded = false;
 	
-	//Character information so we can calculate the width of the image when we need to
-	std::map<const char, const CharacterInfo> CharacterWidthMap;
+	//The metrics of every Latin-1 character and the kerning of every pair of them in font units, made once when the font is loaded.
+	//The kerning is indexed by the left character times 256 plus the right one
+	std::array<GlyphMetrics, 256> LatinMetrics;
+	std::vector<short> Kerning;
+
+	//The other characters and the pairs with one of them are added when they are first used, the key of a pair is the left codepoint
+	//in the upper half and the right one in the lower half. They are shared by the threads of a Layout so they are guarded by the mutex
+	std::unordered_map<int, GlyphMetrics> ExtendedMetrics;
+	std::unordered_map<long long, int> ExtendedKerning;
+	std::mutex MetricsMutex;
 	
+	//Every character gets rasterized once per pixel height, the key is the codepoint in the upper half and the pixel height in the lower half.
+	//The Font is shared by the threads of a Layout so the cache is guarded by the mutex, the glyphs are rasterized outside of it
+	std::unordered_map<long long, std::shared_ptr<GlyphBitmap>> GlyphCache;
+
+	//In the signed distance field mode the fields are kept by codepoint and their Coverage is the distance to the outline,
+	//the GlyphCache only keeps a limited amount of the glyphs scaled from them so it doesn't grow with the amount of pixel heights
+	bool bSDF = false;
+	std::unordered_map<int, std::shared_ptr<GlyphBitmap>> FieldCache;
+	std::mutex GlyphCacheMutex;
+	std::atomic<long long> GlyphCacheHits = 0;
+	std::atomic<long long> GlyphCacheMisses = 0;
+
+	//The rendered text runs, when they take up more memory than the budget the least recently used ones are removed.
+	//The front of the TextRunOrder is the most recently used key and the back the least recently used one
+	void EvictTextRuns();
+	std::unordered_map<std::string, TextRun> TextRuns;
+	std::list<std::string> TextRunOrder;
+	std::unordered_set<std::string> TextRunCandidates;
+	std::mutex TextRunMutex;
+	size_t TextRunBudget = static_cast<size_t>(64) * 1024 * 1024;
+	size_t TextRunMemoryUsed = 0;
+	long long TextRunHits = 0;
+	long long TextRunMisses = 0;
+
 	int Ascent = 0;
 	int Descent = 0;
 	int LineGap = 0;
@@ -0,0 +1,66 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include "Image.h"
+
+//The ways the frames can be put into the stream. Raw is every pixel as RGBA without premultiplied alpha like in the png files,
+//Y4M is a YUV4MPEG2 stream of limited range BT.601 YUV420 frames where the transparent parts are put on black
+enum FrameFormat
+{
+	FrameRaw = 0,
+	FrameY4M = 1
+};
+
+//Writes the images as the frames of a single stream so they can be piped straight into a video encoder instead of being saved as png files.
+//The images can be handed over in any order from any thread, a frame is held back until every frame before it has been written
+class FrameWriter
+{
+public:
+	//An output of "-" writes to stdout, anything else is opened as a file which can also be a named pipe
+	FrameWriter(const std::string& output, const FrameFormat& format, const int& frameRate = 30, const int& frameRateDivisor = 1);
+	~FrameWriter();
+
+	bool IsOpen() { return Stream != nullptr; }
+
+	//Writes out what is still buffered, returns false when a write failed like when the reader closed the pipe before every frame was written
+	bool Flush();
+
+	//Reserves the place of count frames in the stream and returns the index of the first one, the size of the first frames is the size of the stream
+	int ReserveFrames(const int& count, const int& width, const int& height);
+
+	//Converts the image and writes it once the frames before it have been written, an image of another size is cropped or padded with black
+	void WriteFrame(const int& index, const std::shared_ptr<Image>& image);
+
+	//Gives up the place of a frame that couldn't be rendered, nothing is written for it so the frames after it don't wait on it
+	void SkipFrame(const int& index);
+
+	//Waits until the frame is at most the window ahead of the next frame that has to be written so the frames that are held back can't pile up
+	void WaitForWindow(const int& index, const int& window);
+
+	//Turns the image into the bytes of a frame of the given size without the FRAME line of Y4M
+	static std::shared_ptr<unsigned char> ConvertFrame(const std::shared_ptr<Image>& image, const FrameFormat& format, const int& width, const int& height);
+	static size_t GetFrameSize(const FrameFormat& format, const int& width, const int& height);
+
+private:
+	//Writes the frames that are next in line, only one thread does this at a time so the others can keep handing over frames
+	void WritePendingFrames(std::unique_lock<std::mutex>& lock);
+	bool WriteBytes(const void* data, const size_t& size);
+
+	FILE* Stream = nullptr;
+	FrameFormat Format = FrameFormat::FrameRaw;
+	int FrameRate = 30;
+	int FrameRateDivisor = 1;
+	int Width = 0;
+	int Height = 0;
+
+	std::mutex WriterMutex;
+	std::condition_variable FrameWritten;
+	std::map<int, std::shared_ptr<unsigned char>> PendingFrames;
+	int ReservedFrames = 0;
+	int NextFrame = 0;
+	bool bWriting = false;
+	bool bFailed = false;
+};
@@ -1,6 +1,19 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+//The way the pixels of an Image are stored in memory, Float keeps a Pixel of 4 floats per pixel while RGBA8 packs
+//every channel into a single unsigned char which makes the Image a quarter of the size
+enum PixelFormat
+{
+	FormatFloat = 0,
+	FormatRGBA8 = 1
+};
 
 struct Pixel
 {
@@ -17,17 +30,14 @@ struct Pixel
 		a = 0.0f;
 	}
 
-	//Composite the Pixel with another one using Alpha Blending
+	//Composite the Pixel with another one using Alpha Blending, both Pixels are premultiplied by their alpha so every channel is a single multiply-add
 	void Composite(const Pixel& otherPixel) 
 	{
-		float FinalAlpha = a + (1.0f - a) * otherPixel.a;
-		if (FinalAlpha > 0.0f) 
-		{
-			r = (otherPixel.r * otherPixel.a + (1.0f - otherPixel.a) * r * a) / FinalAlpha;
-			g = (otherPixel.g * otherPixel.a + (1.0f - otherPixel.a) * g * a) / FinalAlpha;
-			b = (otherPixel.b * otherPixel.a + (1.0f - otherPixel.a) * b * a) / FinalAlpha;
-			a = FinalAlpha;
-		}
+		float InverseAlpha = 1.0f - otherPixel.a;
+		r = otherPixel.r + InverseAlpha * r;
+		g = otherPixel.g + InverseAlpha * g;
+		b = otherPixel.b + InverseAlpha * b;
+		a = otherPixel.a + InverseAlpha * a;
 	}
 
 	bool operator== (const Pixel& Other) const
@@ -40,23 +50,32 @@ struct Pixel
 	}
 };
 
+//A run of pixels in a row of an Image that isn't fully transparent, the pixels from Start up to End are either all opaque or a mix of alphas
+struct ImageSpan
+{
+	int Start = 0;
+	int End = 0;
+	bool bOpaque = false;
+};
+
 class Image
 {
 public:
 	//The empty constructor should only be used when creating an empty shared pointer which will have it's value assigned from another
 	Image();
 
-	Image(const std::string& filename);
-	Image(const int& width, const int& height);
+	Image(const std::string& filename, const PixelFormat& format = PixelFormat::FormatFloat);
+	Image(const int& width, const int& height, const PixelFormat& format = PixelFormat::FormatFloat);
 
 	//This is the function used by the Font class to turn the text into an image so we add a IsText bool since they have to be loaded in a different way
-	Image(const std::shared_ptr<unsigned char> imageData, const int& width, const int& height, const int& dataComponents = 4, const bool& bIsText = false);
+	Image(const std::shared_ptr<unsigned char> imageData, const int& width, const int& height, const int& dataComponents = 4, const bool& bIsText = false, const PixelFormat& format = PixelFormat::FormatFloat);
 	~Image();
 
-	void SaveImage(const std::string& saveLocation);
+	//The compression level and encode threads are passed on to the PngEncoder, -1 uses its defaults
+	void SaveImage(const std::string& saveLocation, const int& compressionLevel = -1, const int& encodeThreads = -1);
 	void ScaleImage(const float& factor);
 
-	//Ascept Ratio will remain the same
+	//Ascept Ratio will remain the same. The sizes of the resize functions are the untrimmed size, a trimmed image keeps its margins in proportion
 	void ResizeImageHeight(const int& newHeight);
 
 	//Ascept Ratio will remain the same
@@ -64,21 +83,50 @@ public:
 
 	void ResizeImage(const int& newWidth, const int& newHeight);
 	void CompositeImage(const std::shared_ptr<Image> otherImage, const int& widthOffset = 0, const int& heightOffset = 0);
+
+	//Composites a coverage mask like the ones made by the Font class in the given color, this is the same as making an Image out of the mask first.
+	//The stride is the width of a row of the mask when only a part of it is composited, 0 uses the coverageWidth
+	void CompositeCoverage(const unsigned char* coverage, const int& coverageWidth, const int& coverageHeight, const Pixel& color, const int& widthOffset = 0, const int& heightOffset = 0,
+		const int& coverageStride = 0);
 	
 	//Copies the value from another shared Image pointer into this one
 	void CopyValue(const std::shared_ptr<Image> otherImage);
 
-	//This function is mainly used to change the color of generated text images but can be used for other purposes
+	//Converts the stored pixels to the given format, this does nothing if the Image is already stored in that format
+	void ConvertFormat(const PixelFormat& format);
+
+	//This function is mainly used to change the color of generated text images but can be used for other purposes, the color is given without premultiplied alpha
 	void ChangeColor(const std::shared_ptr<Pixel> color, const bool& changeAlpha = false);
 
 	//Functions to manipulate a section of the image
 	void EraseImageSection(const int& sectionWidth, const int& sectionHeight, const int& widthOffset = 0, const int& heightOffset = 0);
 	std::shared_ptr<Image> CopyImageSection(const int& sectionWidth, const int& sectionHeight, const int& widthOffset = 0, const int& heightOffset = 0);
 
+	//Cuts off the fully transparent rows and columns around the pixels so resizing and compositing only work on the content.
+	//The image remembers where the content was so it can still be placed and resized as if it had the untrimmed size
+	void TrimTransparentMargins();
+
+	//Finds the spans of every row so compositing this Image can skip the transparent pixels and copy the opaque ones.
+	//This is done when the pixels are loaded or made and anything that draws onto the Image throws the spans away again
+	void CalculateRowSpans();
+	bool HasRowSpans() { return bRowSpans; }
+
 	//Getters
 	int GetWidth() { return Width; }
 	int GetHeight() { return Height; }
+	PixelFormat GetFormat() { return Format; }
+	int GetUntrimmedWidth() { return bTrimmed ? UntrimmedWidth : Width; }
+	int GetUntrimmedHeight() { return bTrimmed ? UntrimmedHeight : Height; }
+	int GetTrimLeft() { return TrimLeft; }
+	int GetTrimTop() { return TrimTop; }
+	size_t GetDataSize() { return static_cast<size_t>(Width) * Height * (Format == PixelFormat::FormatRGBA8 ? 4 : sizeof(Pixel)); }
+
+	//Only the getter of the current format will return data, the other one will be empty. The colors are premultiplied by the alpha
 	const std::shared_ptr<Pixel> GetData() { return ImageData; }
+	const std::shared_ptr<unsigned char> GetPackedData() { return PackedData; }
+
+	//The pixels as RGBA unsigned chars without premultiplied alpha, the same data that gets saved to the png file
+	std::shared_ptr<unsigned char> GetUnsignedCharData() { return ImageDataToUnsignedChar(); }
 
 	bool operator== (const Image& Other) const
 	{
@@ -87,6 +135,16 @@ public:
 			return false;
 		}
 
+		if (Format != Other.Format)
+		{
+			return false;
+		}
+
+		if (Format == PixelFormat::FormatRGBA8)
+		{
+			return memcmp(PackedData.get(), Other.PackedData.get(), static_cast<size_t>(Width) * Height * 4) == 0;
+		}
+
 		for(int i = 0; i < Width * Height; i++)
 		{
 			if (!(ImageData.get()[i] == Other.ImageData.get()[i]))
@@ -99,13 +157,45 @@ public:
 	}
 
 private:
-	//Convert between the Pixel struct and unsigned char
+	//Convert between the Pixel struct and unsigned char, the unsigned chars are not premultiplied and the stored pixels are
 	void UnsignedCharToImageData(const std::shared_ptr<unsigned char> image, const int& components = 4, const bool& bIsText = false);
 	std::shared_ptr<unsigned char> ImageDataToUnsignedChar();
 
+	//Calculates which part of an image of the given size lands inside this one when it is placed at the offset
+	void CalculateCompositeBounds(const int& otherWidth, const int& otherHeight, const int& widthOffset, const int& heightOffset, int& minimumWidth, int& maxWidth, int& minimumHeight, int& maxHeight);
+
+	//Returns 0 when the pixel at the index is fully transparent, 2 when it is fully opaque and 1 for anything in between
+	int GetAlphaClass(const int& index)
+	{
+		if (Format == PixelFormat::FormatRGBA8)
+		{
+			unsigned char Alpha = PackedData.get()[static_cast<size_t>(index) * 4 + 3];
+			return Alpha == 0 ? 0 : (Alpha == 255 ? 2 : 1);
+		}
+		float Alpha = ImageData.get()[index].a;
+		return Alpha == 0.0f ? 0 : (Alpha == 1.0f ? 2 : 1);
+	}
+
+	//Composites count pixels of the other image onto ours starting at the given pixel indices, opaque pixels are copied instead of blended
+	void CompositeRowSection(const std::shared_ptr<Image>& otherImage, const int& pixel, const int& otherPixel, const int& count, const bool& bOpaque);
+
 	//Image data, the width and height will have their origin in the top left corner of the image with the bottom right corner being their highest values
 	int Width = 0;
 	int Height = 0;
 	int Components = 0; //Amount of channels each pixel has with the option being Grey, Grey & Alpha, RGB, and RGBA
+	PixelFormat Format = PixelFormat::FormatFloat;
 	std::shared_ptr<Pixel> ImageData;
+	std::shared_ptr<unsigned char> PackedData;
+
+	//Where the stored pixels are in the image before it was trimmed and the size it had
+	bool bTrimmed = false;
+	int TrimLeft = 0;
+	int TrimTop = 0;
+	int UntrimmedWidth = 0;
+	int UntrimmedHeight = 0;
+
+	//The spans of all the rows after each other, the spans of a row start at its RowSpanStart and end at the start of the next row
+	std::vector<ImageSpan> RowSpans;
+	std::vector<int> RowSpanStart;
+	bool bRowSpans = false;
 };
@@ -12,7 +12,8 @@ public:
 	int GetDataWidth() override;
 	int GetDataHeight() override;
 
-	void SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font) override;
+	bool PrepareData(const std::shared_ptr<Font>& font) override;
+	void DrawData(const std::shared_ptr<Image>& image, const int& widthOffset, const int& heightOffset) override;
 	void ClearData() override;
 
 	//Setters
@@ -20,6 +21,12 @@ public:
 	void SetRetainAspectRatio(const bool& value) { bRetainAspectRatio = value; }
 
 private:
+	//The image the data is taken from, this is the ResizedImage once PrepareData has been called
+	std::shared_ptr<Image>& GetCurrentImage() { return ResizedImage != nullptr ? ResizedImage : StoredImage; }
+	void CopyStoredImage();
+
+	//The StoredImage is never changed since it can be shared, the ResizedImage is the one that gets drawn
 	std::shared_ptr<Image> StoredImage;
+	std::shared_ptr<Image> ResizedImage;
 	bool bRetainAspectRatio = true;
 };
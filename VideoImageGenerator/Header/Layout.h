@@ -1,35 +1,121 @@
 #pragma once
 #include "ImageBlock.h"
 #include "TextBlock.h"
+#include "AssetCache.h"
+#include "BoundedQueue.h"
+#include "Profiler.h"
+#include "PngEncoder.h"
+#include "FrameWriter.h"
+#include <atomic>
+#include <climits>
+#include <exception>
+#include <map>
+#include <set>
+
+//Settings for a run that come from outside of the json, like the command line
+struct LayoutSettings
+{
+	//The amount of images rendered at the same time, -1 uses the Threads value from the json and 0 uses every core
+	int Threads = -1;
+
+	//Only the images whose index modulo the ShardCount is the ShardIndex are rendered so a batch can be split over multiple processes
+	int ShardIndex = 0;
+	int ShardCount = 1;
+
+	//The amount of images that are read before they get rendered when the json is streamed, 0 uses 4 images per thread
+	int BatchSize = 0;
+
+	//Splits the rendering into a stage that decodes the assets, one that composes the images and one that encodes and writes them,
+	//which all run at the same time on different images. Without it every thread does all of the stages of an image one after the other
+	bool bPipeline = true;
+
+	//The png compression level from 0 to 9, -1 uses the CompressionLevel value from the json
+	int CompressionLevel = -1;
+
+	//Draws the blocks that have the same data in every image of a batch into a layer once, so every image starts from a copy of that layer
+	//and only the blocks that change have to be drawn
+	bool bStaticLayer = true;
+
+	//Cuts the transparent margins off of the StoredImages when they are loaded so resizing and compositing them only work on the content.
+	//The blocks keep the size of the untrimmed images but resized images can end up slightly different at the edges of the content
+	bool bTrimImages = false;
+
+	//Renders the text from a signed distance field of every character instead of rasterizing the characters for every pixel height,
+	//which keeps the glyph cache small when a font is used at many sizes. The edges of the text are a bit softer
+	bool bSDFText = false;
+
+	//When there is a Writer the images are written to it as the frames of a stream instead of being saved as png files.
+	//Every layout that is given the same Writer adds its frames after the ones of the layouts before it
+	std::shared_ptr<FrameWriter> Writer;
+};
+
+//An image on its way through the pipeline, the assets are kept here so they can't be removed from the AssetCache before the image is composed
+struct PipelineFrame
+{
+	int Index = 0;
+	int StreamIndex = 0;
+	std::string Filename = "";
+	std::vector<std::shared_ptr<Image>> Assets;
+	std::shared_ptr<Image> Result;
+
+	//The profiler frame moves between the threads with the image, the frame time is only the time spent working on it and not waiting in the queues
+	FrameReport Report;
+	long long FrameNanoseconds = 0;
+};
 
 class Layout
 {
 public:
-	Layout(const nlohmann::json& JData);
+	Layout(const nlohmann::json& JData, const LayoutSettings& settings = LayoutSettings());
+
+	//Reads the json from the stream and renders the Images while they are being read so only a batch of them is in memory at a time.
+	//The Layout has to come before the Images for this, otherwise the Images are kept until the Layout has been read
+	Layout(std::istream& stream, const LayoutSettings& settings = LayoutSettings());
 	~Layout();
 
+	//False when the streamed json couldn't be parsed or didn't have a Layout and an Images list
+	bool IsValid() { return bValid; }
+
 private:
 	//Functions to make the layout, add the data to the blocks in the layout, and save the images
 	void Initialize(const nlohmann::json& JData);
+	std::shared_ptr<BaseBlock> MakeCanvas(const nlohmann::json& JData);
 	void GoThroughData(const nlohmann::json& JData);
-	void SaveImage(const std::string& saveLocation);
+	void StreamData(std::istream& stream);
+	void RenderBatch(const nlohmann::json& JData);
+	void RenderPipeline(const nlohmann::json& JData);
+	void RenderFrames(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas);
+	void RenderFrame(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const int& streamIndex);
+	void SkipFrame(const int& streamIndex, const std::exception& exception);
+	void PrefetchAssets(const nlohmann::json& JData, std::vector<std::shared_ptr<Image>>& assets);
+
+	//Functions to find the blocks that are the same in every image of the batch and draw them into the StaticLayer.
+	//The blocks are found by their path which is the names of the blocks from the Canvas down to them
+	void PrepareStaticLayer(const nlohmann::json& JData);
+	void CollectBlockData(const nlohmann::json& JData, const std::string& path, std::map<std::string, nlohmann::json>& blockData);
+	void FindStaticBlocks(const std::shared_ptr<BaseBlock>& block, const std::string& path, const std::map<std::string, nlohmann::json>& blockData,
+						  const std::set<std::string>& varyingBlocks, bool& bVaryingDrawn, std::set<std::string>& staticBlocks);
+	void MarkStaticBlocks(const std::shared_ptr<BaseBlock>& block, const std::string& path, const bool& bParentStatic);
+	std::shared_ptr<Image> ComposeImage(const std::shared_ptr<BaseBlock>& canvas);
+
+	//Grows the bounds so they include the part of the item that is drawn on an image of the given size
+	static void AddToBounds(const RenderItem& item, const int& width, const int& height, int& left, int& top, int& right, int& bottom);
 
 	//Setters
 	void SetFont(const std::shared_ptr<Font>& font);
 	void SetBackgroundImage(const std::string& filename);
 	void SetBackgroundImage(const std::shared_ptr<Image>& image);
 
-	//Adders
-	void AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& previousBlock = nullptr);
+	//Adders, the canvas is the root of the block tree that is being worked on as every thread has its own
+	void AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& previousBlock = nullptr);
 	void AddPotentialLayouts(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& currentBlock);
 	void AddBaseBlockData(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& currentBlock, const bool& override = false);
-	void AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& previousBlock = nullptr);
+	void AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& previousBlock = nullptr);
 
 	//Finders
-	void FindBlock(std::shared_ptr<BaseBlock>& foundBlock, const std::shared_ptr<BaseBlock>& currentBlock, const std::string& name);
+	void FindBlock(std::shared_ptr<BaseBlock>& foundBlock, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& currentBlock, const std::string& name);
 	std::shared_ptr<BaseBlock> FindBlock(const std::vector<std::shared_ptr<BaseBlock>>& list, const std::string& name);
 	nlohmann::json FindLayout(const std::vector<std::shared_ptr<PotentialLayout>>& list, const std::string& name);
-	void FindLowestHeight(const std::shared_ptr<BaseBlock>& currentBlock, int& value);
 
 	//These variables determine how tall the bottom section is and how many pixels from the bottom of the image there should be to the lowest block
 	int BottomHeight = 0;
@@ -38,7 +124,49 @@ private:
 	//Blocks that will store the layout
 	std::shared_ptr<BaseBlock> Canvas;
 
+	//The blocks hold the data of the image they are working on so every thread builds its own copy of the blocks from the layout json.
+	//The Font and BackgroundImage are shared between the threads
+	nlohmann::json LayoutJData;
+	int Threads = 1;
+
+	//The png compression level and the threads used for every image, -1 uses the defaults of the PngEncoder
+	int CompressionLevel = -1;
+	int EncodeThreads = -1;
+	std::atomic<int> NextFrame = 0;
+	std::vector<int> Frames;
+
+	//The index in the stream of the Writer of the first image of the batch
+	int FirstStreamFrame = 0;
+	LayoutSettings Settings;
+	bool bValid = true;
+
+	//The canvases of the extra threads are kept so they don't have to be made again for every batch
+	std::vector<std::shared_ptr<BaseBlock>> WorkerCanvases;
+
+	//The blocks that are drawn into the StaticLayer and the data they were drawn with, the layer is kept for the next batch if those are the same.
+	//The lowest height of the static blocks is kept as well since they are still used to find the lowest block of every image
+	std::set<std::string> StaticBlocks;
+	nlohmann::json StaticBlockData;
+	std::shared_ptr<Image> StaticLayer;
+	int StaticLowestHeight = 0;
+
+	//The background with the StaticLayer already on it and the area of the StaticLayer the static blocks were drawn in
+	std::shared_ptr<Image> StaticBackground;
+	int StaticLeft = INT_MAX;
+	int StaticTop = INT_MAX;
+	int StaticRight = 0;
+	int StaticBottom = 0;
+	void ResetStaticBounds() { StaticLeft = INT_MAX; StaticTop = INT_MAX; StaticRight = 0; StaticBottom = 0; }
+
 	std::shared_ptr<Font> TextFont;
 	std::shared_ptr<Image> BackgroundImage;
+
+	//The format every Image made by this layout is stored in, RGBA8 uses a quarter of the memory of Float
+	PixelFormat ImageFormat = PixelFormat::FormatFloat;
+
+	//Whether the StoredImages get their transparent margins cut off and whether the font uses signed distance fields,
+	//these are on when either the settings or the json ask for them
+	bool bTrimImages = false;
+	bool bSDFText = false;
 	std::string SaveFilePath = "";
 };
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//Maps a file into memory so it can be read without copying it into a buffer first, the pages come from the page cache
+//which every process that maps the same file shares. Files that can't be mapped, like pipes, are read into a buffer instead
+class MappedFile
+{
+public:
+	MappedFile(const std::string& filename);
+	~MappedFile();
+
+	//The mapping can't be shared by 2 objects since both would try to unmap it
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool IsOpen() { return bOpen; }
+	bool IsMapped() { return bMapped; }
+
+	//The data stays valid as long as the MappedFile exists, it must not be written to
+	const unsigned char* GetData() { return bMapped ? MappedData : Buffer.data(); }
+	size_t GetSize() { return Size; }
+
+private:
+	bool ReadFile(const std::string& filename);
+
+	const unsigned char* MappedData = nullptr;
+	std::vector<unsigned char> Buffer;
+	size_t Size = 0;
+	bool bOpen = false;
+	bool bMapped = false;
+
+	//The handles of the file and the mapping which Windows needs to close them again
+#if defined(_WIN32)
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+};
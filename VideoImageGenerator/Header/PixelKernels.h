@@ -0,0 +1,44 @@
+#pragma once
+#include "Image.h"
+
+//The instruction sets the PixelKernels can use, the best one the CPU supports gets picked by a static initializer when the program starts
+enum KernelInstructionSet
+{
+	KernelScalar = 0,
+	KernelSSE41 = 1,
+	KernelAVX2 = 2
+};
+
+//Functions that work on whole rows of pixels at once so the work can be vectorized, every kernel has a scalar version which gives the same result
+class PixelKernels
+{
+public:
+	//Blends count premultiplied otherPixels over the pixels in the row, this gives the same result as calling Pixel::Composite for every pixel
+	static void CompositeRow(Pixel* row, const Pixel* otherRow, const int& count);
+
+	//The RGBA8 version of CompositeRow, the results stay within 1/255 of the Float version
+	static void CompositePackedRow(unsigned char* row, const unsigned char* otherRow, const int& count);
+
+	//Blends count pixels of the color over the row using the coverage as the alpha, the color is not premultiplied.
+	//With a white color this gives the same result as compositing an Image made from the coverage with bIsText
+	static void CompositeCoverageRow(Pixel* row, const unsigned char* coverageRow, const int& count, const Pixel& color);
+
+	//The RGBA8 version of CompositeCoverageRow
+	static void CompositePackedCoverageRow(unsigned char* row, const unsigned char* coverageRow, const int& count, const Pixel& color);
+
+	//Turn count premultiplied RGBA8 pixels into the limited range BT.601 luma of a YUV420 frame, which is the same as putting them on black first
+	static void ConvertLumaRow(const unsigned char* row, const int& count, unsigned char* lumaRow);
+
+	//Makes the (count + 1) / 2 chroma samples of a row pair from the average of every 2x2 block, the last column is repeated when count is odd
+	static void ConvertChromaRow(const unsigned char* row, const unsigned char* nextRow, const int& count, unsigned char* uRow, unsigned char* vRow);
+
+	//The instruction set can be lowered to test or benchmark the other versions, it can't be raised above what the CPU supports
+	static void SetInstructionSet(const KernelInstructionSet& instructionSet);
+	static KernelInstructionSet GetInstructionSet();
+
+private:
+	static KernelInstructionSet DetectInstructionSet();
+
+	static KernelInstructionSet SupportedInstructionSet;
+	static KernelInstructionSet ActiveInstructionSet;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+
+//Writes 8 bit png files. The filtered rows are split into chunks that are deflated on their own threads, every chunk can still refer back
+//to the end of the one before it and ends on a byte boundary so they can be joined into a single zlib stream.
+//The chunks have a fixed size so the file is the same no matter how many threads were used
+class PngEncoder
+{
+public:
+	//Encodes the pixels which have components channels each and aren't premultiplied, returns an empty vector if the size isn't valid.
+	//The level and threads are used for this image only, -1 uses the defaults below so callers with their own settings don't affect each other
+	static std::vector<unsigned char> Encode(const unsigned char* data, const int& width, const int& height, const int& components = 4, const int& level = -1, const int& threads = -1);
+	static bool WriteFile(const std::string& filename, const unsigned char* data, const int& width, const int& height, const int& components = 4, size_t* bytesWritten = nullptr,
+		const int& level = -1, const int& threads = -1);
+
+	//The default compression level for the whole process, 0 stores the data without compressing it, 1 is the fastest compression and 9 gives the smallest files.
+	//It starts at 3
+	static void SetCompressionLevel(const int& level);
+	static int GetCompressionLevel() { return CompressionLevel; }
+
+	//The default amount of threads that work on a single image for the whole process, 0 uses every core.
+	//The extra threads are kept in a pool that is shared by every image, a single thread encodes the image without any of them
+	static void SetThreads(const int& threads);
+	static int GetThreads() { return Threads; }
+
+	//Checksums of the zlib stream and the png chunks, the adler of 2 pieces of data can be combined when the length of the second one is known
+	static unsigned int Adler32(const unsigned char* data, const size_t& length, unsigned int adler = 1);
+	static unsigned int CombineAdler32(const unsigned int& firstAdler, const unsigned int& secondAdler, const size_t& secondLength);
+	static unsigned int Crc32(const unsigned char* data, const size_t& length, unsigned int crc = 0);
+
+private:
+	static void FilterRow(const unsigned char* row, const unsigned char* previousRow, const int& rowBytes, const int& components, unsigned char* filteredRow, unsigned char* scratch);
+	static void DeflateChunk(const unsigned char* data, const size_t& dictionaryStart, const size_t& start, const size_t& end, const int& level, const bool& bLast, std::vector<unsigned char>& out);
+
+	static std::atomic<int> CompressionLevel;
+	static std::atomic<int> Threads;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../Library/json/json.hpp"
+
+//The stages the time of a run is split into, a stage started inside another stage is also counted in the outer one
+enum ProfilerStage
+{
+	StageParse = 0,
+	StageDecode = 1,
+	StageText = 2,
+	StageResize = 3,
+	StageComposite = 4,
+	StageConvert = 5,
+	StageEncode = 6,
+	StageFrame = 7,
+	StageCount = 8
+};
+
+//Things that are counted during a run
+enum ProfilerCounter
+{
+	CounterPixelsComposited = 0,
+	CounterBytesWritten = 1,
+	CounterAssetCacheHits = 2,
+	CounterAssetCacheMisses = 3,
+	CounterResizeCacheHits = 4,
+	CounterResizeCacheMisses = 5,
+	CounterGlyphCacheHits = 6,
+	CounterGlyphCacheMisses = 7,
+	CounterTextRunHits = 8,
+	CounterTextRunMisses = 9,
+	CounterCount = 10
+};
+
+//The time spent in every stage and the counters of a single frame or of the whole run
+struct ProfilerStats
+{
+	long long StageNanoseconds[ProfilerStage::StageCount] = {};
+	long long StageCalls[ProfilerStage::StageCount] = {};
+	long long Counters[ProfilerCounter::CounterCount] = {};
+
+	void Add(const ProfilerStats& other);
+	nlohmann::json ToJson() const;
+};
+
+struct FrameReport
+{
+	std::string Name;
+	ProfilerStats Stats;
+};
+
+//The total, lowest and highest time of every stage over all the frames, kept as running values so a long run doesn't have to keep every frame
+struct FrameSpread
+{
+	long long FrameCount = 0;
+	ProfilerStats Total;
+	long long MinimumNanoseconds[ProfilerStage::StageCount] = {};
+	long long MaximumNanoseconds[ProfilerStage::StageCount] = {};
+
+	void Add(const ProfilerStats& frame);
+	nlohmann::json ToJson() const;
+};
+
+//Collects the stage times and counters. Everything is gathered per thread while a frame is being rendered and added to the run when the frame ends,
+//so the threads only have to lock once per frame. When the Profiler isn't enabled nothing is measured
+class Profiler
+{
+public:
+	static void SetEnabled(const bool& value);
+	static bool IsEnabled() { return bEnabled; }
+
+	static void BeginFrame(const std::string& name);
+	static void EndFrame();
+
+	//Takes the frame of this thread so it can be continued on another thread with ResumeFrame, for when the stages of a frame run on different threads
+	static FrameReport SuspendFrame();
+	static void ResumeFrame(const FrameReport& report);
+
+	static void AddStageTime(const ProfilerStage& stage, const long long& nanoseconds);
+	static void AddCount(const ProfilerCounter& counter, const long long& amount = 1);
+
+	//How many frames are listed one by one in the report, the frames after that only count towards the totals
+	static const size_t MaximumFrameReports = 1024;
+
+	//Writes the totals of the run, the spread of the frames and the first frames to a json file
+	static nlohmann::json MakeReport();
+	static bool WriteReport(const std::string& filename);
+	static void Reset();
+
+	static const char* GetStageName(const ProfilerStage& stage);
+	static const char* GetCounterName(const ProfilerCounter& counter);
+
+private:
+	static bool bEnabled;
+	static std::chrono::steady_clock::time_point RunStart;
+
+	static std::mutex ProfilerMutex;
+	static ProfilerStats RunStats;
+	static FrameSpread FrameTotals;
+	static std::vector<FrameReport> Frames;
+};
+
+//Adds the time between its creation and destruction to a stage
+class ScopedTimer
+{
+public:
+	ScopedTimer(const ProfilerStage& stage);
+	~ScopedTimer();
+
+private:
+	ProfilerStage Stage;
+	bool bActive = false;
+	std::chrono::steady_clock::time_point Start;
+};
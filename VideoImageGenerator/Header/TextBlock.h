@@ -13,7 +13,8 @@ public:
 	int GetDataWidth() override;
 	int GetDataHeight() override;
 
-	void SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font) override;
+	bool PrepareData(const std::shared_ptr<Font>& font) override;
+	void DrawData(const std::shared_ptr<Image>& image, const int& widthOffset, const int& heightOffset) override;
 	void ClearData() override;
 
 	//Setters
@@ -21,6 +22,7 @@ public:
 	void SetPixelHeight(const int& value) { PixelHeight = value; }
 	void SetCalculatedWidth(const int& value) { CalculatedWidth = value; }
 	void SetColor(const std::shared_ptr<Pixel>& value) { Color = value; }
+	void SetPixelFormat(const PixelFormat& value) { Format = value; }
 
 	//Getters
 	const std::string GetText() { return Text; }
@@ -31,4 +33,14 @@ private:
 	int PixelHeight = 16;
 	int CalculatedWidth = 0;
 	std::shared_ptr<Pixel> Color;
+
+	//The format of the image the text is drawn onto, the text is converted to it once when it is rendered instead of every time it is drawn
+	PixelFormat Format = PixelFormat::FormatFloat;
+
+	//The text turned into an image by PrepareData so it can be drawn, it comes from the text runs of the font so it is shared and must not be changed
+	std::shared_ptr<Image> TextImage;
+
+	//Text that the font hasn't seen before has no run, it is shaped instead and its characters are drawn straight onto the image
+	std::shared_ptr<Font> TextFont;
+	ShapedText Shaped;
 };
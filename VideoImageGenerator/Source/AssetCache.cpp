@@ -0,0 +1,202 @@
+#include "../Header/AssetCache.h"
+#include "../Header/Profiler.h"
+#include <cstdint>
+#include <filesystem>
+
+std::unordered_map<std::string, CachedAsset> AssetCache::Assets;
+std::list<std::string> AssetCache::UsageOrder;
+std::mutex AssetCache::AssetMutex;
+size_t AssetCache::MemoryBudget = static_cast<size_t>(512) * 1024 * 1024;
+size_t AssetCache::MemoryUsed = 0;
+long long AssetCache::Hits = 0;
+long long AssetCache::Misses = 0;
+long long AssetCache::ResizeHits = 0;
+long long AssetCache::ResizeMisses = 0;
+
+std::shared_ptr<Image> AssetCache::GetImage(const std::string& filename, const PixelFormat& format, const bool& bTrim)
+{
+	//Different ways to write the same path should end up at the same image so the canonical path is used in the key,
+	//if we can't get the information of the file we let the Image report why it can't be loaded
+	std::error_code Error;
+	std::filesystem::path CanonicalPath = std::filesystem::canonical(filename, Error);
+	unsigned long long FileSize = Error ? 0 : std::filesystem::file_size(CanonicalPath, Error);
+	long long LastWriteTime = Error ? 0 : std::filesystem::last_write_time(CanonicalPath, Error).time_since_epoch().count();
+	if (Error)
+	{
+		return std::shared_ptr<Image>(new Image(filename, format));
+	}
+
+	std::string Key = CanonicalPath.string() + "|" + std::to_string(format) + (bTrim ? "|trim" : "");
+	{
+		std::lock_guard<std::mutex> Lock(AssetMutex);
+		auto Asset = Assets.find(Key);
+		if (Asset != Assets.end())
+		{
+			if (Asset->second.LastWriteTime == LastWriteTime && Asset->second.FileSize == FileSize)
+			{
+				Hits++;
+				Profiler::AddCount(ProfilerCounter::CounterAssetCacheHits);
+				UsageOrder.splice(UsageOrder.begin(), UsageOrder, Asset->second.UsageIterator);
+				return Asset->second.StoredImage;
+			}
+
+			//The file has changed since it was loaded so the old image is removed
+			RemoveAsset(Asset);
+		}
+		Misses++;
+		Profiler::AddCount(ProfilerCounter::CounterAssetCacheMisses);
+	}
+
+	//Decode outside of the lock so other threads can keep using the cache, if 2 threads load the same file the first one is kept
+	std::shared_ptr<Image> NewImage(new Image(filename, format));
+	if (NewImage->GetWidth() == 0 || NewImage->GetHeight() == 0)
+	{
+		return NewImage;
+	}
+
+	if (bTrim)
+	{
+		NewImage->TrimTransparentMargins();
+	}
+
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	auto Asset = Assets.find(Key);
+	if (Asset != Assets.end())
+	{
+		return Asset->second.StoredImage;
+	}
+
+	CachedAsset NewAsset;
+	NewAsset.StoredImage = NewImage;
+	NewAsset.LastWriteTime = LastWriteTime;
+	NewAsset.FileSize = FileSize;
+	AddAsset(Key, NewAsset);
+	return NewImage;
+}
+
+std::shared_ptr<Image> AssetCache::FindResizedImage(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio)
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	auto Asset = Assets.find(MakeResizeKey(source, width, height, bRetainAspectRatio));
+	if (Asset != Assets.end())
+	{
+		if (Asset->second.SourceImage.lock() == source)
+		{
+			ResizeHits++;
+			Profiler::AddCount(ProfilerCounter::CounterResizeCacheHits);
+			UsageOrder.splice(UsageOrder.begin(), UsageOrder, Asset->second.UsageIterator);
+			return Asset->second.StoredImage;
+		}
+
+		//The image it was made from is gone and this is a new image at the same address
+		RemoveAsset(Asset);
+	}
+
+	ResizeMisses++;
+	Profiler::AddCount(ProfilerCounter::CounterResizeCacheMisses);
+	return nullptr;
+}
+
+void AssetCache::AddResizedImage(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio, const std::shared_ptr<Image>& resizedImage)
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	std::string Key = MakeResizeKey(source, width, height, bRetainAspectRatio);
+	if (Assets.find(Key) != Assets.end())
+	{
+		return;
+	}
+
+	CachedAsset NewAsset;
+	NewAsset.StoredImage = resizedImage;
+	NewAsset.SourceImage = source;
+	AddAsset(Key, NewAsset);
+}
+
+void AssetCache::SetMemoryBudget(const size_t& bytes)
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	MemoryBudget = bytes;
+	EvictToBudget();
+}
+
+size_t AssetCache::GetMemoryBudget()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return MemoryBudget;
+}
+
+size_t AssetCache::GetMemoryUsed()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return MemoryUsed;
+}
+
+void AssetCache::Clear()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	Assets.clear();
+	UsageOrder.clear();
+	MemoryUsed = 0;
+	Hits = 0;
+	Misses = 0;
+	ResizeHits = 0;
+	ResizeMisses = 0;
+}
+
+long long AssetCache::GetHits()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return Hits;
+}
+
+long long AssetCache::GetMisses()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return Misses;
+}
+
+long long AssetCache::GetResizeHits()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return ResizeHits;
+}
+
+long long AssetCache::GetResizeMisses()
+{
+	std::lock_guard<std::mutex> Lock(AssetMutex);
+	return ResizeMisses;
+}
+
+//The functions below have to be called while holding the AssetMutex
+void AssetCache::AddAsset(const std::string& key, CachedAsset& asset)
+{
+	asset.DataSize = asset.StoredImage->GetDataSize();
+	UsageOrder.push_front(key);
+	asset.UsageIterator = UsageOrder.begin();
+	Assets.insert(std::pair<std::string, CachedAsset>(key, asset));
+	MemoryUsed += asset.DataSize;
+
+	EvictToBudget();
+}
+
+void AssetCache::RemoveAsset(const std::unordered_map<std::string, CachedAsset>::iterator& asset)
+{
+	MemoryUsed -= asset->second.DataSize;
+	UsageOrder.erase(asset->second.UsageIterator);
+	Assets.erase(asset);
+}
+
+//Images that are still used by a block stay alive through their shared_ptr
+void AssetCache::EvictToBudget()
+{
+	while (MemoryUsed > MemoryBudget && !UsageOrder.empty())
+	{
+		RemoveAsset(Assets.find(UsageOrder.back()));
+	}
+}
+
+//The key starts with a character that can't start a canonical path so it can't be the same as the key of a file
+std::string AssetCache::MakeResizeKey(const std::shared_ptr<Image>& source, const int& width, const int& height, const bool& bRetainAspectRatio)
+{
+	return "*" + std::to_string(reinterpret_cast<uintptr_t>(source.get())) + "|" + std::to_string(width) + "|" + std::to_string(height) + "|" + std::to_string(bRetainAspectRatio);
+}
@@ -261,14 +261,48 @@ int BaseBlock::CalculateRightWidth()
 	return CalculateLeftWidth() + GetDataWidth();
 }
 
-void BaseBlock::SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font)
+void BaseBlock::CompileRenderPlan(std::vector<RenderItem>& plan, const std::shared_ptr<Font>& font, const int& previousWidthOffset, const int& previousHeightOffset)
 {
+	//The blocks linked to a static block are static as well so none of them have to be added
+	if (bStatic)
+	{
+		return;
+	}
+
+	//The data has to be prepared first since the alignment and snapping depend on its size
+	RenderItem Item;
+	Item.Block = shared_from_this();
+	Item.bDraw = PrepareData(font);
+
+	//This is the same as CalculateLeftWidth and CalculateTopHeight but the offsets of the previous blocks have already been added up
+	Item.WidthOffset = previousWidthOffset + WidthOffset - CalculateWidthAlignment();
+	Item.HeightOffset = previousHeightOffset + HeightOffset - CalculateHeightAlignment();
+	Item.BottomHeight = Item.HeightOffset + GetDataHeight();
+	if (Item.bDraw)
+	{
+		CalculateAndAddSnapCorrection(Item.WidthOffset, Item.HeightOffset);
+	}
+	Item.Width = GetDataWidth();
+	Item.Height = GetDataHeight();
+	plan.push_back(Item);
+
 	for (std::shared_ptr<BaseBlock> CurrentBlock : LinkedBlocks)
 	{
-		CurrentBlock->SaveImage(image, font);
+		CurrentBlock->CompileRenderPlan(plan, font, previousWidthOffset + WidthOffset + SnapWidthCorrection, previousHeightOffset + HeightOffset + SnapHeightCorrection);
 	}
 }
 
+//The BaseBlock doesn't contain any data so there is nothing to prepare or draw
+bool BaseBlock::PrepareData(const std::shared_ptr<Font>& /*font*/)
+{
+	return false;
+}
+
+void BaseBlock::DrawData(const std::shared_ptr<Image>& /*image*/, const int& /*widthOffset*/, const int& /*heightOffset*/)
+{
+
+}
+
 void BaseBlock::ClearData()
 {
 	SnapWidthCorrection = 0;
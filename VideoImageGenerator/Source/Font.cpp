@@ -1,12 +1,26 @@
 #include "../Header/Font.h"
+#include "../Header/Profiler.h"
+#include <algorithm>
 #define STB_TRUETYPE_IMPLEMENTATION
-#include "../library/stb/stb_truetype.h"
+#include "../Library/stb/stb_truetype.h"
 //Code took heavy inspiration from: https://github.com/justinmeiners/stb-truetype-example/blob/master/main.c 
 
-Font::Font(const std::string& filePath)
+//The glyphs of an SDF font are rasterized at this height with this much padding around them. A distance of SDFPixelDistance
+//is one pixel at that height and SDFOnEdge is the outline, so the padding reaches from the outline to a distance of 0
+static const int SDFPixelHeight = 64;
+static const int SDFPadding = 8;
+static const unsigned char SDFOnEdge = 128;
+static const float SDFPixelDistance = 16.0f;
+
+//The glyphs scaled from the fields are cached per pixel height as well, when there are more than this many they are all forgotten
+//so the cache doesn't grow with the amount of pixel heights the way it does for rasterized glyphs
+static const size_t MaximumFieldGlyphs = 2048;
+
+Font::Font(const std::string& filePath, const bool& bSignedDistanceField)
 {
+	bSDF = bSignedDistanceField;
 	Init(filePath);
-	MakeCharacterWidthMap();
+	MakeMetricTables();
 }
 
 Font::~Font()
@@ -16,34 +30,15 @@ Font::~Font()
 
 void Font::Init(const std::string& filePath)
 {
-	//Initialize variables
-	//I am using a pointer and not a shared pointer because I would need to make the shared_ptr<FILE*> to work with fopen_s
-	//but this causes it to not work with the rest of the code below
-	FILE* FontFile = NULL;
-	long Size = 0;
-
-	//Open the FontFile
-	fopen_s(&FontFile, filePath.c_str(), "rb");
-
-	//Read the file and copy the files data to the buffer
-	if (FontFile)
+	//The font is read straight from its mapping, stbtt only reads from the data so it can keep pointing into it
+	FontFile = std::shared_ptr<MappedFile>(new MappedFile(filePath));
+	if (FontFile->IsOpen() && FontFile->GetSize() > 0)
 	{
-		//Get the size of the file
-		fseek(FontFile, 0, SEEK_END);
-		Size = ftell(FontFile);
-		fseek(FontFile, 0, SEEK_SET);
-
-		//Make a buffer the size of the file so we can load it in
-		Buffer = std::shared_ptr<unsigned char>(new unsigned char[Size]);
-
-		//Read the Fontfile and write all of it to the Info variable
-		fread(Buffer.get(), Size, 1, FontFile);
-		stbtt_InitFont(&Info, Buffer.get(), 0);
-
-		//Close the FontFile
-		fclose(FontFile);
-		FontFile = NULL;
+		bLoaded = stbtt_InitFont(&Info, const_cast<unsigned char*>(FontFile->GetData()), 0) != 0;
+	}
 
+	if (bLoaded)
+	{
 		//Get the values which are for how high above and below the baseline the characters go,
 		//LineGap being the difference between the lines in the font image
 		stbtt_GetFontVMetrics(&Info, &Ascent, &Descent, &LineGap);
@@ -54,40 +49,208 @@ void Font::Init(const std::string& filePath)
 	}
 }
 
-void Font::MakeCharacterWidthMap() 
+//Reads the codepoint that starts at the index and moves the index past it. Bytes that aren't valid UTF-8 become the replacement character,
+//a sequence that ends early only uses up the bytes before the one that broke it
+static int DecodeUTF8(const std::string& text, size_t& index)
+{
+	const int ReplacementCharacter = 0xFFFD;
+	unsigned char Lead = static_cast<unsigned char>(text[index++]);
+	if (Lead < 0x80)
+	{
+		return Lead;
+	}
+
+	int Length = 0;
+	int Codepoint = 0;
+	int Minimum = 0;
+	if ((Lead & 0xE0) == 0xC0)
+	{
+		Length = 1;
+		Codepoint = Lead & 0x1F;
+		Minimum = 0x80;
+	}
+	else if ((Lead & 0xF0) == 0xE0)
+	{
+		Length = 2;
+		Codepoint = Lead & 0x0F;
+		Minimum = 0x800;
+	}
+	else if ((Lead & 0xF8) == 0xF0)
+	{
+		Length = 3;
+		Codepoint = Lead & 0x07;
+		Minimum = 0x10000;
+	}
+	else
+	{
+		return ReplacementCharacter;
+	}
+
+	for (int i = 0; i < Length; i++)
+	{
+		if (index >= text.size() || (static_cast<unsigned char>(text[index]) & 0xC0) != 0x80)
+		{
+			return ReplacementCharacter;
+		}
+		Codepoint = (Codepoint << 6) | (static_cast<unsigned char>(text[index++]) & 0x3F);
+	}
+
+	//Overlong encodings, surrogates and codepoints past the last one aren't valid either
+	if (Codepoint < Minimum || Codepoint > 0x10FFFF || (Codepoint >= 0xD800 && Codepoint <= 0xDFFF))
+	{
+		return ReplacementCharacter;
+	}
+	return Codepoint;
+}
+
+void Font::MakeMetricTables()
+{
+	//Without a font every advance and kern stays 0 and ShapeText gives no characters so nothing reads a font that isn't there
+	LatinMetrics.fill(GlyphMetrics());
+	Kerning.assign(256 * 256, 0);
+	if (!bLoaded)
+	{
+		return;
+	}
+
+	//Every Latin-1 character is looked up once, the glyph indices let the kerning skip finding both glyphs for every pair
+	for (int Character = 0; Character < 256; Character++)
+	{
+		LatinMetrics[Character] = MakeGlyphMetrics(Character);
+	}
+
+	//The pair with the terminating null of the string is in the table as well since the last character of a string is kerned with it
+	if (Info.kern || Info.gpos)
+	{
+		for (int Left = 0; Left < 256; Left++)
+		{
+			for (int Right = 0; Right < 256; Right++)
+			{
+				Kerning[Left * 256 + Right] = static_cast<short>(stbtt_GetGlyphKernAdvance(&Info, LatinMetrics[Left].GlyphIndex, LatinMetrics[Right].GlyphIndex));
+			}
+		}
+	}
+}
+
+GlyphMetrics Font::MakeGlyphMetrics(const int& codepoint)
+{
+	GlyphMetrics Metrics;
+	int LeftSideBearing = 0;
+	Metrics.GlyphIndex = stbtt_FindGlyphIndex(&Info, codepoint);
+	stbtt_GetGlyphHMetrics(&Info, Metrics.GlyphIndex, &Metrics.Advance, &LeftSideBearing);
+	return Metrics;
+}
+
+//The characters past Latin-1 are looked up the first time they are used, the MetricsMutex has to be held for them.
+//Negative values aren't codepoints so they get the metrics of the null character
+const GlyphMetrics& Font::GetGlyphMetrics(const int& codepoint)
+{
+	if (codepoint < 0)
+	{
+		return LatinMetrics[0];
+	}
+	if (codepoint < 256)
+	{
+		return LatinMetrics[codepoint];
+	}
+
+	auto Metrics = ExtendedMetrics.find(codepoint);
+	if (Metrics == ExtendedMetrics.end())
+	{
+		Metrics = ExtendedMetrics.insert(std::pair<int, GlyphMetrics>(codepoint, MakeGlyphMetrics(codepoint))).first;
+	}
+	return Metrics->second;
+}
+
+int Font::GetKerning(const int& leftCodepoint, const int& rightCodepoint)
 {
-	//Make a string with all the characters we will initialize for this map
-	//Note: If a character outside of these gets used the code will break
-	std::string Alphabet{"aAbBcCdDeEfFgGhHiIjJkKlLmMnNoOpPqQrRsStTuUvVwWxXyYzZ 0123456789+-_=:.,'\""};
-	CharacterInfo temp;
+	if (leftCodepoint < 0 || rightCodepoint < 0)
+	{
+		return 0;
+	}
+	if (leftCodepoint < 256 && rightCodepoint < 256)
+	{
+		return Kerning[leftCodepoint * 256 + rightCodepoint];
+	}
 
-	//Go throught every letter in the alphabet along with " ", 0-9, and some special characters and load all the width and offsets
-	for (int i = 0; i < Alphabet.size(); ++i)
+	long long Key = (static_cast<long long>(leftCodepoint) << 32) | static_cast<unsigned int>(rightCodepoint);
+	auto Kern = ExtendedKerning.find(Key);
+	if (Kern == ExtendedKerning.end())
 	{
-		//Get the Characters width and how far away it needs to be placed and add them to the map
-		stbtt_GetCodepointHMetrics(&Info, Alphabet[i], &temp.CharacterWidth, &temp.LeftSideOffset);
-		CharacterWidthMap.insert(std::pair<char, CharacterInfo>(Alphabet[i], temp));
+		int Advance = stbtt_GetGlyphKernAdvance(&Info, GetGlyphMetrics(leftCodepoint).GlyphIndex, GetGlyphMetrics(rightCodepoint).GlyphIndex);
+		Kern = ExtendedKerning.insert(std::pair<long long, int>(Key, Advance)).first;
 	}
+	return Kern->second;
+}
+
+ShapedText Font::ShapeText(const std::string& text, const int& characterPixelHeight)
+{
+	ShapedText Shaped;
+	if (!bLoaded)
+	{
+		return Shaped;
+	}
+
+	//The text is UTF-8, only text with characters past Latin-1 needs the lock since the Latin-1 tables never change
+	std::vector<int> Codepoints;
+	Codepoints.reserve(text.size());
+	bool bExtended = false;
+	for (size_t i = 0; i < text.size();)
+	{
+		Codepoints.push_back(DecodeUTF8(text, i));
+		bExtended = bExtended || Codepoints.back() >= 256;
+	}
+
+	std::unique_lock<std::mutex> Lock(MetricsMutex, std::defer_lock);
+	if (bExtended)
+	{
+		Lock.lock();
+	}
+
+	Shaped.Glyphs.reserve(Codepoints.size());
+	float Scale = GetScale(characterPixelHeight);
+	for (size_t i = 0; i < Codepoints.size(); i++)
+	{
+		//The last character is kerned with 0 like it was with the terminating null of the string
+		int NextCodepoint = i + 1 < Codepoints.size() ? Codepoints[i + 1] : 0;
+		const GlyphMetrics& Metrics = GetGlyphMetrics(Codepoints[i]);
+		Shaped.Glyphs.push_back(ShapedGlyph{ Codepoints[i], Metrics.GlyphIndex, Shaped.Width });
+
+		//Add the width of the character and the spacing between it and the next character for this font
+		Shaped.Width += static_cast<int>(roundf(Metrics.Advance * Scale));
+		Shaped.Width += static_cast<int>(roundf(GetKerning(Codepoints[i], NextCodepoint) * Scale));
+	}
+
+	return Shaped;
 }
 
 std::shared_ptr<Image> Font::GetTextImage(const std::string& text, const int& characterPixelHeight)
 {
-	//Create a canvas where the character images will be printed onto
-	std::shared_ptr<Image> TextImage(new Image{ GetStringLength(text, characterPixelHeight), characterPixelHeight });
+	ScopedTimer Timer(ProfilerStage::StageText);
+
+	//The same shaping gives the size of the canvas and where every character goes on it, the text is white and gets its color from the TextBlock
+	ShapedText Shaped = ShapeText(text, characterPixelHeight);
+	std::shared_ptr<Image> TextImage(new Image{ Shaped.Width, characterPixelHeight });
+	DrawShapedText(TextImage, Shaped, characterPixelHeight, Pixel{ 1.0f, 1.0f, 1.0f, 1.0f });
+
+	//Most of a text image is the space around the characters which the spans let the TextBlock skip
+	TextImage->CalculateRowSpans();
+	return TextImage;
+}
 
+void Font::DrawShapedText(const std::shared_ptr<Image>& image, const ShapedText& shaped, const int& characterPixelHeight, const Pixel& color, const int& widthOffset, const int& heightOffset)
+{
 	//Initialze variables we are going to need
 	float Scale = GetScale(characterPixelHeight);
-	int XOffset = 0;
 	int ScaledAscent = static_cast<int>(roundf(Ascent * Scale));
 	int YOffsetRoundingErrorCorrection = 0;
 
-	for (int i = 0; i < text.size(); ++i)
+	for (const ShapedGlyph& CurrentGlyph : shaped.Glyphs)
 	{
 		//Get the YOffset because the characters shouldn't be added at the top,
 		//we will need to correct some of the rounding errors as the offset can result in -1
-		int YOffset;
-		stbtt_GetCodepointBitmapBox(&Info, text[i], Scale, Scale, 0, &YOffset, 0, 0);
-		YOffset += ScaledAscent;
+		std::shared_ptr<GlyphBitmap> Glyph = GetGlyphBitmap(CurrentGlyph.Codepoint, characterPixelHeight);
+		int YOffset = Glyph->TopOffset + ScaledAscent;
 		if (YOffset < 0) 
 		{
 			YOffsetRoundingErrorCorrection = -1 * YOffset;
@@ -98,65 +261,301 @@ std::shared_ptr<Image> Font::GetTextImage(const std::string& text, const int& ch
 			YOffset += YOffsetRoundingErrorCorrection;
 		}
 
-		//Add the character at the right location
-		TextImage->CompositeImage(GetCharacterImage(&text[i], characterPixelHeight), XOffset, YOffset);
+		//The characters are cut off at the edges of the text like they would be on a text image of the width and pixel height of the text,
+		//the edges of the image are handled by CompositeCoverage
+		int VisibleWidth = std::min(Glyph->Width, shaped.Width - CurrentGlyph.XOffset);
+		int VisibleHeight = std::min(Glyph->Height, characterPixelHeight - YOffset);
+		if (VisibleWidth <= 0 || VisibleHeight <= 0)
+		{
+			continue;
+		}
+
+		image->CompositeCoverage(Glyph->Coverage.get(), VisibleWidth, VisibleHeight, color, widthOffset + CurrentGlyph.XOffset, heightOffset + YOffset, Glyph->Width);
+	}
+}
+
+std::shared_ptr<Image> Font::GetTextRunImage(const std::string& text, const int& characterPixelHeight, const std::shared_ptr<Pixel>& color, const PixelFormat& format, const bool& bRepeatedOnly)
+{
+	//The color is added as its bytes so 2 colors that only differ a little don't end up with the same key, the text goes last since it can contain anything
+	std::string Key = std::to_string(format) + "|" + std::to_string(characterPixelHeight) + "|";
+	if (color.get())
+	{
+		Key.append(reinterpret_cast<const char*>(color.get()), sizeof(Pixel));
+	}
+	Key += "|" + text;
+
+	{
+		std::lock_guard<std::mutex> Lock(TextRunMutex);
+		auto Run = TextRuns.find(Key);
+		if (Run != TextRuns.end())
+		{
+			TextRunHits++;
+			Profiler::AddCount(ProfilerCounter::CounterTextRunHits);
+			TextRunOrder.splice(TextRunOrder.begin(), TextRunOrder, Run->second.UsageIterator);
+			return Run->second.RunImage;
+		}
+		TextRunMisses++;
+		Profiler::AddCount(ProfilerCounter::CounterTextRunMisses);
 
-		//Update the XOffset by adding the new character and the spacing between it and the next character for this font 
-		XOffset += static_cast<int>(roundf(CharacterWidthMap.at(text[i]).CharacterWidth * Scale));
-		if (i != text.size())
+		//The first time a run is asked for only its key is kept, so text that is only drawn once doesn't push the other runs out.
+		//When there are too many keys they are all forgotten so text that never repeats can't take up more and more memory
+		const size_t MaximumCandidates = 65536;
+		if (bRepeatedOnly && TextRunCandidates.insert(Key).second)
 		{
-			int Kern;
-			Kern = stbtt_GetCodepointKernAdvance(&Info, text[i], text[i + 1]);
-			XOffset += static_cast<int>(roundf(Kern * Scale));
+			if (TextRunCandidates.size() > MaximumCandidates)
+			{
+				TextRunCandidates.clear();
+			}
+			return nullptr;
 		}
+		TextRunCandidates.erase(Key);
 	}
 
-	return TextImage;
+	//The color is changed before converting the format so the run is the same as the text image that used to be converted while compositing it.
+	//It is rendered outside of the lock so other threads can keep using the runs, if 2 threads render the same run the first one is kept
+	std::shared_ptr<Image> RunImage = GetTextImage(text, characterPixelHeight);
+	if (color.get())
+	{
+		RunImage->ChangeColor(color);
+	}
+	RunImage->ConvertFormat(format);
+
+	std::lock_guard<std::mutex> Lock(TextRunMutex);
+	auto Run = TextRuns.find(Key);
+	if (Run != TextRuns.end())
+	{
+		return Run->second.RunImage;
+	}
+
+	TextRun NewRun;
+	NewRun.RunImage = RunImage;
+	NewRun.DataSize = RunImage->GetDataSize();
+	TextRunOrder.push_front(Key);
+	NewRun.UsageIterator = TextRunOrder.begin();
+	TextRuns.insert(std::pair<std::string, TextRun>(Key, NewRun));
+	TextRunMemoryUsed += NewRun.DataSize;
+
+	EvictTextRuns();
+	return RunImage;
+}
+
+void Font::SetTextRunBudget(const size_t& bytes)
+{
+	std::lock_guard<std::mutex> Lock(TextRunMutex);
+	TextRunBudget = bytes;
+	EvictTextRuns();
+}
+
+size_t Font::GetTextRunMemoryUsed()
+{
+	std::lock_guard<std::mutex> Lock(TextRunMutex);
+	return TextRunMemoryUsed;
+}
+
+//Has to be called while holding the TextRunMutex, runs that are still used by a block stay alive through their shared_ptr
+void Font::EvictTextRuns()
+{
+	while (TextRunMemoryUsed > TextRunBudget && !TextRunOrder.empty())
+	{
+		auto Run = TextRuns.find(TextRunOrder.back());
+		TextRunMemoryUsed -= Run->second.DataSize;
+		TextRuns.erase(Run);
+		TextRunOrder.pop_back();
+	}
 }
 
 std::shared_ptr<Image> Font::GetCharacterImage(const char* text, const int& characterPixelHeight) 
 {
+	//The text is UTF-8 so the first character can take up more than 1 byte, an empty string gives the null character
+	std::string Text(text);
+	size_t Index = 0;
+	int Codepoint = Text.empty() ? 0 : DecodeUTF8(Text, Index);
+	std::shared_ptr<GlyphBitmap> Glyph = GetGlyphBitmap(Codepoint, characterPixelHeight);
+	return std::shared_ptr<Image>(new Image(Glyph->Coverage, Glyph->Width, Glyph->Height, 1, true));
+}
+
+std::shared_ptr<GlyphBitmap> Font::GetGlyphBitmap(const int& codepoint, const int& characterPixelHeight)
+{
+	long long Key = (static_cast<long long>(codepoint) << 32) | static_cast<unsigned int>(characterPixelHeight);
+	{
+		std::lock_guard<std::mutex> Lock(GlyphCacheMutex);
+		auto CachedGlyph = GlyphCache.find(Key);
+		if (CachedGlyph != GlyphCache.end())
+		{
+			GlyphCacheHits++;
+			Profiler::AddCount(ProfilerCounter::CounterGlyphCacheHits);
+			return CachedGlyph->second;
+		}
+	}
+
+	//A glyph that has to be scaled from its field counts as a hit or miss of the field, so the misses are only the fields that had to be made
+	if (bSDF)
+	{
+		std::shared_ptr<GlyphBitmap> Glyph = MakeGlyphFromField(codepoint, characterPixelHeight);
+		std::lock_guard<std::mutex> Lock(GlyphCacheMutex);
+		if (GlyphCache.size() >= MaximumFieldGlyphs)
+		{
+			GlyphCache.clear();
+		}
+		return GlyphCache.emplace(Key, Glyph).first->second;
+	}
+	GlyphCacheMisses++;
+	Profiler::AddCount(ProfilerCounter::CounterGlyphCacheMisses);
+
 	float Scale = GetScale(characterPixelHeight);
+	int GlyphIndex = 0;
+	{
+		std::lock_guard<std::mutex> MetricsLock(MetricsMutex);
+		GlyphIndex = GetGlyphMetrics(codepoint).GlyphIndex;
+	}
 	
-	//Get the bounding box around the letter
+	//Get the bounding box around the letter, the glyph is rasterized without holding the lock so the other threads can keep using the cache
 	int Left = 0;
 	int Bottom = 0;
 	int Right = 0;
 	int Top = 0;
-	stbtt_GetCodepointBitmapBox(&Info, *text, Scale, Scale, &Left, &Bottom, &Right, &Top);
+	stbtt_GetGlyphBitmapBox(&Info, GlyphIndex, Scale, Scale, &Left, &Bottom, &Right, &Top);
 
-	int CharacterWidth = Right - Left;
-	int CharacterHeight = Top - Bottom;
+	std::shared_ptr<GlyphBitmap> Glyph(new GlyphBitmap());
+	Glyph->Width = Right - Left;
+	Glyph->Height = Top - Bottom;
+	Glyph->LeftOffset = Left;
+	Glyph->TopOffset = Bottom;
 	
-	//Create a bitmap to write the character into. This bitmap will be turned into an image and returned
-	std::shared_ptr<unsigned char> Bitmap(new unsigned char[CharacterHeight * CharacterWidth]);
-	stbtt_MakeCodepointBitmap(&Info, Bitmap.get(), Right - Left, Top - Bottom, CharacterWidth, Scale, Scale, *text);
-	return std::shared_ptr<Image>(new Image(Bitmap, CharacterWidth, CharacterHeight, 1, true));
+	//Create a bitmap to write the character into, it is kept for every following frame that uses this character
+	Glyph->Coverage = std::shared_ptr<unsigned char>(new unsigned char[Glyph->Height * Glyph->Width], std::default_delete<unsigned char[]>());
+	stbtt_MakeGlyphBitmap(&Info, Glyph->Coverage.get(), Glyph->Width, Glyph->Height, Glyph->Width, Scale, Scale, GlyphIndex);
+
+	//If another thread rasterized the same glyph in the meantime its glyph is kept and returned instead
+	std::lock_guard<std::mutex> Lock(GlyphCacheMutex);
+	return GlyphCache.emplace(Key, Glyph).first->second;
 }
 
-int Font::GetStringLength(const std::string& text, const int& characterPixelHeight) 
+std::shared_ptr<GlyphBitmap> Font::GetGlyphField(const int& codepoint)
+{
+	//The fields are cached for every codepoint but not for every pixel height, the offsets are the ones of the field at the SDFPixelHeight
+	{
+		std::lock_guard<std::mutex> Lock(GlyphCacheMutex);
+		auto CachedField = FieldCache.find(codepoint);
+		if (CachedField != FieldCache.end())
+		{
+			GlyphCacheHits++;
+			Profiler::AddCount(ProfilerCounter::CounterGlyphCacheHits);
+			return CachedField->second;
+		}
+	}
+	GlyphCacheMisses++;
+	Profiler::AddCount(ProfilerCounter::CounterGlyphCacheMisses);
+
+	int GlyphIndex = 0;
+	{
+		std::lock_guard<std::mutex> MetricsLock(MetricsMutex);
+		GlyphIndex = GetGlyphMetrics(codepoint).GlyphIndex;
+	}
+
+	//Characters without an outline like a space don't get a field and stay empty, the field is made without holding the lock like a rasterized glyph
+	std::shared_ptr<GlyphBitmap> Field(new GlyphBitmap());
+	unsigned char* Distances = stbtt_GetGlyphSDF(&Info, GetScale(SDFPixelHeight), GlyphIndex, SDFPadding, SDFOnEdge, SDFPixelDistance,
+		&Field->Width, &Field->Height, &Field->LeftOffset, &Field->TopOffset);
+	if (Distances == nullptr)
+	{
+		Field->Width = 0;
+		Field->Height = 0;
+	}
+	else
+	{
+		Field->Coverage = std::shared_ptr<unsigned char>(Distances, [](unsigned char* distances) { stbtt_FreeSDF(distances, nullptr); });
+	}
+
+	std::lock_guard<std::mutex> Lock(GlyphCacheMutex);
+	return FieldCache.emplace(codepoint, Field).first->second;
+}
+
+std::shared_ptr<GlyphBitmap> Font::MakeGlyphFromField(const int& codepoint, const int& characterPixelHeight)
 {
+	std::shared_ptr<GlyphBitmap> Field = GetGlyphField(codepoint);
 	float Scale = GetScale(characterPixelHeight);
-	int Length = 0;
+	int GlyphIndex = 0;
+	{
+		std::lock_guard<std::mutex> MetricsLock(MetricsMutex);
+		GlyphIndex = GetGlyphMetrics(codepoint).GlyphIndex;
+	}
+
+	//The glyph gets the same box as a rasterized glyph so the text is laid out the same way in both modes
+	int Left = 0;
+	int Bottom = 0;
+	int Right = 0;
+	int Top = 0;
+	stbtt_GetGlyphBitmapBox(&Info, GlyphIndex, Scale, Scale, &Left, &Bottom, &Right, &Top);
 
-	for (int i = 0; i < text.size(); i++)
+	std::shared_ptr<GlyphBitmap> Glyph(new GlyphBitmap());
+	Glyph->Width = Right - Left;
+	Glyph->Height = Top - Bottom;
+	Glyph->LeftOffset = Left;
+	Glyph->TopOffset = Bottom;
+	Glyph->Coverage = std::shared_ptr<unsigned char>(new unsigned char[Glyph->Height * Glyph->Width](), std::default_delete<unsigned char[]>());
+	if (Field->Coverage == nullptr)
 	{
-		//Get the Characters width and how far away it needs to be placed and add them to the map
-		Length += static_cast<int>(roundf(CharacterWidthMap.at(text[i]).CharacterWidth * Scale));
+		return Glyph;
+	}
+
+	//Every pixel samples the field at its center, the distance in pixels at this height is turned into coverage
+	//with the outline halfway through the pixel so the edges are smoothed over one pixel
+	float Ratio = Scale / GetScale(SDFPixelHeight);
+	const unsigned char* Distances = Field->Coverage.get();
 
-		//Add spacing
-		if (i != text.size()) 
+	//Samples outside of the field are past the padding so they are as far outside of the outline as the field goes
+	auto Sample = [&](const int& sampleX, const int& sampleY) -> float
 		{
-			int Kern;
-			Kern = stbtt_GetCodepointKernAdvance(&Info, text[i], text[i + 1]);
-			Length += static_cast<int>(roundf(Kern * Scale));
+			if (sampleX < 0 || sampleY < 0 || sampleX >= Field->Width || sampleY >= Field->Height)
+			{
+				return 0.0f;
+			}
+			return Distances[sampleY * Field->Width + sampleX];
+		};
+
+	//The columns of the field are the same for every row so they are only worked out once
+	std::vector<int> Columns(Glyph->Width);
+	std::vector<float> ColumnWeights(Glyph->Width);
+	for (int x = 0; x < Glyph->Width; x++)
+	{
+		float FieldX = (Left + x + 0.5f) / Ratio - Field->LeftOffset - 0.5f;
+		Columns[x] = static_cast<int>(floorf(FieldX));
+		ColumnWeights[x] = FieldX - Columns[x];
+	}
+
+	for (int y = 0; y < Glyph->Height; y++)
+	{
+		float FieldY = (Bottom + y + 0.5f) / Ratio - Field->TopOffset - 0.5f;
+		int Row = static_cast<int>(floorf(FieldY));
+		float RowWeight = FieldY - Row;
+		for (int x = 0; x < Glyph->Width; x++)
+		{
+			int Column = Columns[x];
+			float UpperLeft = Sample(Column, Row);
+			float LowerLeft = Sample(Column, Row + 1);
+			float UpperDistance = UpperLeft + (Sample(Column + 1, Row) - UpperLeft) * ColumnWeights[x];
+			float LowerDistance = LowerLeft + (Sample(Column + 1, Row + 1) - LowerLeft) * ColumnWeights[x];
+			float Distance = UpperDistance + (LowerDistance - UpperDistance) * RowWeight;
+
+			float Coverage = (Distance - SDFOnEdge) / SDFPixelDistance * Ratio + 0.5f;
+			Glyph->Coverage.get()[y * Glyph->Width + x] = static_cast<unsigned char>(std::clamp(Coverage, 0.0f, 1.0f) * 255.0f + 0.5f);
 		}
 	}
 
-	return Length;
+	return Glyph;
+}
+
+int Font::GetStringLength(const std::string& text, const int& characterPixelHeight) 
+{
+	return ShapeText(text, characterPixelHeight).Width;
 }
 
 float Font::GetScale(const int& characterPixelHeight)
 {
+	if (!bLoaded)
+	{
+		return 0.0f;
+	}
 	return stbtt_ScaleForPixelHeight(&Info, static_cast<float>(characterPixelHeight));
 }
@@ -0,0 +1,265 @@
+#include "../Header/FrameWriter.h"
+#include <algorithm>
+#include <vector>
+#include "../Header/PixelKernels.h"
+#include "../Header/Profiler.h"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <unistd.h>
+#endif
+
+FrameWriter::FrameWriter(const std::string& output, const FrameFormat& format, const int& frameRate, const int& frameRateDivisor)
+{
+	Format = format;
+	FrameRate = frameRate;
+	FrameRateDivisor = frameRateDivisor;
+
+#if !defined(_WIN32)
+	//A reader that closes the pipe early would end the program through SIGPIPE, this way the write fails and the error gets printed
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	if (output == "-")
+	{
+		//The stream takes over stdout and stdout is pointed at stderr so the messages printed during the run can't end up between the frames
+		fflush(stdout);
+#if defined(_WIN32)
+		int Descriptor = _dup(_fileno(stdout));
+		_dup2(_fileno(stderr), _fileno(stdout));
+		_setmode(Descriptor, _O_BINARY);
+		Stream = _fdopen(Descriptor, "wb");
+#else
+		int Descriptor = dup(fileno(stdout));
+		dup2(fileno(stderr), fileno(stdout));
+		Stream = fdopen(Descriptor, "wb");
+#endif
+	}
+	else
+	{
+		//fopen_s only exists on Windows
+#if defined(_WIN32)
+		fopen_s(&Stream, output.c_str(), "wb");
+#else
+		Stream = fopen(output.c_str(), "wb");
+#endif
+	}
+
+	if (Stream == nullptr)
+	{
+		printf("Couldn't open %s to write the frames to.\n", output.c_str());
+		return;
+	}
+
+	//A frame is written in a few large pieces so a bigger buffer saves on the amount of writes to the pipe
+	setvbuf(Stream, nullptr, _IOFBF, 1 << 20);
+}
+
+FrameWriter::~FrameWriter()
+{
+	if (Stream != nullptr)
+	{
+		fclose(Stream);
+	}
+}
+
+int FrameWriter::ReserveFrames(const int& count, const int& width, const int& height)
+{
+	std::unique_lock<std::mutex> Lock(WriterMutex);
+	if (ReservedFrames == 0)
+	{
+		Width = width;
+		Height = height;
+		if (Format == FrameFormat::FrameY4M)
+		{
+			char Header[128];
+			int Length = snprintf(Header, sizeof(Header), "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", Width, Height, FrameRate, FrameRateDivisor);
+			bFailed = !WriteBytes(Header, Length);
+		}
+	}
+	else if (width != Width || height != Height)
+	{
+		printf("The frames are %dx%d but the stream is %dx%d so they will be cropped or padded with black.\n", width, height, Width, Height);
+	}
+
+	int FirstFrame = ReservedFrames;
+	ReservedFrames += count;
+	return FirstFrame;
+}
+
+void FrameWriter::WriteFrame(const int& index, const std::shared_ptr<Image>& image)
+{
+	std::shared_ptr<unsigned char> Frame;
+	{
+		ScopedTimer Timer(ProfilerStage::StageConvert);
+		Frame = ConvertFrame(image, Format, Width, Height);
+	}
+	Profiler::AddCount(ProfilerCounter::CounterBytesWritten, static_cast<long long>(GetFrameSize(Format, Width, Height)));
+
+	std::unique_lock<std::mutex> Lock(WriterMutex);
+	PendingFrames[index] = Frame;
+	if (!bWriting)
+	{
+		WritePendingFrames(Lock);
+	}
+}
+
+void FrameWriter::SkipFrame(const int& index)
+{
+	std::unique_lock<std::mutex> Lock(WriterMutex);
+	PendingFrames[index] = nullptr;
+	if (!bWriting)
+	{
+		WritePendingFrames(Lock);
+	}
+}
+
+void FrameWriter::WaitForWindow(const int& index, const int& window)
+{
+	std::unique_lock<std::mutex> Lock(WriterMutex);
+	FrameWritten.wait(Lock, [&]() { return index - NextFrame <= window; });
+}
+
+void FrameWriter::WritePendingFrames(std::unique_lock<std::mutex>& lock)
+{
+	bWriting = true;
+	std::map<int, std::shared_ptr<unsigned char>>::iterator Next = PendingFrames.find(NextFrame);
+	while (Next != PendingFrames.end())
+	{
+		std::shared_ptr<unsigned char> Frame = Next->second;
+		PendingFrames.erase(Next);
+
+		//The lock isn't held while writing as a full pipe blocks until the encoder has read from it.
+		//Once a write failed the frames are thrown away so nothing keeps waiting on them, a skipped frame has nothing to write
+		if (!bFailed && Frame != nullptr)
+		{
+			lock.unlock();
+			bool bWritten = true;
+			{
+				ScopedTimer Timer(ProfilerStage::StageEncode);
+				if (Format == FrameFormat::FrameY4M)
+				{
+					bWritten = WriteBytes("FRAME\n", 6);
+				}
+				bWritten = bWritten && WriteBytes(Frame.get(), GetFrameSize(Format, Width, Height));
+			}
+			lock.lock();
+
+			if (!bWritten)
+			{
+				printf("Writing frame %d failed, the frames after it won't be written.\n", NextFrame);
+				bFailed = true;
+			}
+		}
+
+		NextFrame++;
+		FrameWritten.notify_all();
+		Next = PendingFrames.find(NextFrame);
+	}
+	bWriting = false;
+}
+
+bool FrameWriter::Flush()
+{
+	std::unique_lock<std::mutex> Lock(WriterMutex);
+	bFailed = bFailed || Stream == nullptr || fflush(Stream) != 0;
+	return !bFailed;
+}
+
+bool FrameWriter::WriteBytes(const void* data, const size_t& size)
+{
+	return Stream != nullptr && fwrite(data, 1, size, Stream) == size;
+}
+
+size_t FrameWriter::GetFrameSize(const FrameFormat& format, const int& width, const int& height)
+{
+	if (format == FrameFormat::FrameY4M)
+	{
+		size_t ChromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+		return static_cast<size_t>(width) * height + ChromaSize * 2;
+	}
+	return static_cast<size_t>(width) * height * 4;
+}
+
+//Returns a row of the image as width premultiplied RGBA8 pixels, the parts outside of the image are transparent
+static const unsigned char* GetPremultipliedRow(const std::shared_ptr<Image>& image, const int& row, const int& width, std::vector<unsigned char>& scratch)
+{
+	int CopyWidth = std::min(width, image->GetWidth());
+	if (row >= image->GetHeight())
+	{
+		std::fill(scratch.begin(), scratch.end(), 0);
+		return scratch.data();
+	}
+
+	if (image->GetFormat() == PixelFormat::FormatRGBA8)
+	{
+		const unsigned char* Data = image->GetPackedData().get() + static_cast<size_t>(row) * image->GetWidth() * 4;
+		if (CopyWidth == width)
+		{
+			return Data;
+		}
+		memcpy(scratch.data(), Data, static_cast<size_t>(CopyWidth) * 4);
+	}
+	else
+	{
+		const Pixel* Data = image->GetData().get() + static_cast<size_t>(row) * image->GetWidth();
+		for (int i = 0; i < CopyWidth; i++)
+		{
+			scratch[i * 4] = static_cast<unsigned char>(std::min(Data[i].r, 1.0f) * 255.0f + 0.5f);
+			scratch[i * 4 + 1] = static_cast<unsigned char>(std::min(Data[i].g, 1.0f) * 255.0f + 0.5f);
+			scratch[i * 4 + 2] = static_cast<unsigned char>(std::min(Data[i].b, 1.0f) * 255.0f + 0.5f);
+			scratch[i * 4 + 3] = static_cast<unsigned char>(std::min(Data[i].a, 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+	std::fill(scratch.begin() + static_cast<size_t>(CopyWidth) * 4, scratch.end(), 0);
+	return scratch.data();
+}
+
+std::shared_ptr<unsigned char> FrameWriter::ConvertFrame(const std::shared_ptr<Image>& image, const FrameFormat& format, const int& width, const int& height)
+{
+	if (format == FrameFormat::FrameRaw && image->GetWidth() == width && image->GetHeight() == height)
+	{
+		return image->GetUnsignedCharData();
+	}
+
+	std::shared_ptr<unsigned char> Frame(new unsigned char[GetFrameSize(format, width, height)](), std::default_delete<unsigned char[]>());
+	if (format == FrameFormat::FrameRaw)
+	{
+		//Only the part that fits is copied, the rest stays transparent black
+		std::shared_ptr<unsigned char> ImageBytes = image->GetUnsignedCharData();
+		int CopyWidth = std::min(width, image->GetWidth());
+		for (int y = 0; y < std::min(height, image->GetHeight()); y++)
+		{
+			memcpy(Frame.get() + static_cast<size_t>(y) * width * 4, ImageBytes.get() + static_cast<size_t>(y) * image->GetWidth() * 4, static_cast<size_t>(CopyWidth) * 4);
+		}
+		return Frame;
+	}
+
+	//The premultiplied colors are the colors on black so the stored pixels can be converted without undoing the alpha.
+	//Every chroma row is made from 2 rows of pixels and the last row is used twice when the height is odd
+	unsigned char* LumaPlane = Frame.get();
+	unsigned char* UPlane = LumaPlane + static_cast<size_t>(width) * height;
+	unsigned char* VPlane = UPlane + static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+	std::vector<unsigned char> Scratch(static_cast<size_t>(width) * 4);
+	std::vector<unsigned char> NextScratch(static_cast<size_t>(width) * 4);
+	for (int y = 0; y < height; y += 2)
+	{
+		const unsigned char* Row = GetPremultipliedRow(image, y, width, Scratch);
+		const unsigned char* NextRow = Row;
+		PixelKernels::ConvertLumaRow(Row, width, LumaPlane + static_cast<size_t>(y) * width);
+		if (y + 1 < height)
+		{
+			NextRow = GetPremultipliedRow(image, y + 1, width, NextScratch);
+			PixelKernels::ConvertLumaRow(NextRow, width, LumaPlane + static_cast<size_t>(y + 1) * width);
+		}
+
+		size_t ChromaOffset = static_cast<size_t>(y / 2) * ((width + 1) / 2);
+		PixelKernels::ConvertChromaRow(Row, NextRow, width, UPlane + ChromaOffset, VPlane + ChromaOffset);
+	}
+
+	return Frame;
+}
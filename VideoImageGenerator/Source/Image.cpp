@@ -1,57 +1,113 @@
 #include "../Header/Image.h"
+#include "../Header/MappedFile.h"
+#include "../Header/PixelKernels.h"
+#include "../Header/Profiler.h"
+#include "../Header/PngEncoder.h"
+#include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include "../Library/stb/stb_image.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "../Library/stb/stb_image_write.h"
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "../Library/stb/stb_image_resize2.h"
 
+//Divide a product of 2 unsigned chars by 255 with rounding without doing the division
+static inline int DivideBy255(const int& value)
+{
+	return (value + 128 + ((value + 128) >> 8)) >> 8;
+}
+
+//Finds the part of a side of the resized image that the content of a trimmed image can reach. The filters stb uses reach 2 pixels
+//of the larger of the 2 sizes, a little more is included so the rounding can't cut anything off
+static void CalculateResizedRange(const int& trimStart, const int& size, const int& untrimmedSize, const int& newSize, int& newStart, int& newEnd)
+{
+	double Scale = static_cast<double>(newSize) / untrimmedSize;
+	double Reach = 2.0 * std::max(1.0, 1.0 / Scale) + 1.0;
+	newStart = std::max(0, static_cast<int>(floor((trimStart - Reach) * Scale)) - 1);
+	newEnd = std::min(newSize, static_cast<int>(ceil((trimStart + size + Reach) * Scale)) + 1);
+}
+
 Image::Image() 
 {
 
 }
 
-Image::Image(const std::string& filename)
+Image::Image(const std::string& filename, const PixelFormat& format)
 {
-	std::shared_ptr<unsigned char> RawImageData(stbi_load(filename.c_str(), &Width, &Height, &Components, 0));
-	if (RawImageData.get() == NULL)
+	ScopedTimer Timer(ProfilerStage::StageDecode);
+	Format = format;
+
+	//The file is decoded straight from its mapping so it doesn't get read into a buffer of its own first
+	MappedFile File(filename);
+	std::shared_ptr<unsigned char> RawImageData;
+	if (!File.IsOpen())
 	{
-		printf("Image: %s failed to load because %s\n", filename.c_str(), stbi_failure_reason());
+		printf("Image: %s failed to load because the file could not be opened\n", filename.c_str());
+	}
+	else
+	{
+		RawImageData = std::shared_ptr<unsigned char>(stbi_load_from_memory(File.GetData(), static_cast<int>(File.GetSize()), &Width, &Height, &Components, 0), stbi_image_free);
+		if (RawImageData.get() == NULL)
+		{
+			printf("Image: %s failed to load because %s\n", filename.c_str(), stbi_failure_reason());
+		}
 	}
 
 	UnsignedCharToImageData(RawImageData, Components);
 	Components = 4; //This is done because after the data is loaded and converted it will have 4 Components
 }
 
-Image::Image(const int& width, const int& height) 
+Image::Image(const int& width, const int& height, const PixelFormat& format) 
 {
 	Width = width;
 	Height = height;
-	ImageData.reset(new Pixel[Width * Height]);
+	Format = format;
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		PackedData.reset(new unsigned char[Width * Height * 4](), std::default_delete<unsigned char[]>());
+	}
+	else
+	{
+		ImageData.reset(new Pixel[Width * Height], std::default_delete<Pixel[]>());
+	}
 	Components = 4;
 }
 
-Image::Image(const std::shared_ptr<unsigned char> imageData, const int& width, const int& height, const int& dataComponents, const bool& bIsText)
+Image::Image(const std::shared_ptr<unsigned char> imageData, const int& width, const int& height, const int& dataComponents, const bool& bIsText, const PixelFormat& format)
 {
 	Width = width;
 	Height = height;
+	Format = format;
 	UnsignedCharToImageData(imageData, dataComponents, bIsText);
 	Components = 4; //This is done because after the data is loaded and converted it will have 4 Components
 }
 
 Image::~Image() 
 {
-	for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
+	if (ImageData)
 	{
-		ImageData.get()[currentPixel].Reset();
+		for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
+		{
+			ImageData.get()[currentPixel].Reset();
+		}
 	}
 }
 
-void Image::SaveImage(const std::string& saveLocation) 
+void Image::SaveImage(const std::string& saveLocation, const int& compressionLevel, const int& encodeThreads)
 {
-	if (!stbi_write_png(saveLocation.c_str(), Width, Height, Components, ImageDataToUnsignedChar().get(), Width * Components))
+	std::shared_ptr<unsigned char> ImageBytes;
 	{
-		printf("Image failed to save at: %s because %s\n", saveLocation.c_str(), stbi_failure_reason());
+		ScopedTimer Timer(ProfilerStage::StageConvert);
+		ImageBytes = ImageDataToUnsignedChar();
+	}
+
+	ScopedTimer Timer(ProfilerStage::StageEncode);
+	size_t BytesWritten = 0;
+	if (!PngEncoder::WriteFile(saveLocation, ImageBytes.get(), Width, Height, Components, &BytesWritten, compressionLevel, encodeThreads))
+	{
+		printf("Image failed to save at: %s\n", saveLocation.c_str());
+	}
+	else
+	{
+		Profiler::AddCount(ProfilerCounter::CounterBytesWritten, static_cast<long long>(BytesWritten));
 	}
 }
 
@@ -59,7 +115,7 @@ void Image::ScaleImage(const float& factor)
 {
 	if (factor) 
 	{
-		ResizeImage(static_cast<int>(Width * factor), static_cast<int>(Height * factor));
+		ResizeImage(static_cast<int>(GetUntrimmedWidth() * factor), static_cast<int>(GetUntrimmedHeight() * factor));
 	}
 	else 
 	{
@@ -69,99 +125,276 @@ void Image::ScaleImage(const float& factor)
 
 void Image::ResizeImageHeight(const int& newHeight)
 {
-	float Scale = 1.0f / Height * newHeight;
-	ResizeImage(static_cast<int>(roundf(Width * Scale)), newHeight);
+	float Scale = 1.0f / GetUntrimmedHeight() * newHeight;
+	ResizeImage(static_cast<int>(roundf(GetUntrimmedWidth() * Scale)), newHeight);
 }
 
 void Image::ResizeImageWidth(const int& newWidth)
 {
-	float Scale = 1.0f / Width * newWidth;
-	ResizeImage(newWidth, static_cast<int>(roundf(Height * Scale)));
+	float Scale = 1.0f / GetUntrimmedWidth() * newWidth;
+	ResizeImage(newWidth, static_cast<int>(roundf(GetUntrimmedHeight() * Scale)));
 }
 
 void Image::ResizeImage(const int& newWidth, const int& newHeight) 
 {
-	std::shared_ptr<unsigned char> ResizedData(stbir_resize_uint8_srgb(ImageDataToUnsignedChar().get(), Width, Height, Width * Components, NULL, newWidth, newHeight, newWidth * Components, STBIR_RGBA));
-	if (ResizedData) 
+	//The resize is done in sRGB on colors that aren't premultiplied so we convert to unsigned chars and back, which for RGBA8 only undoes and redoes the alpha
+	std::shared_ptr<unsigned char> ResizedData;
+	if (!bTrimmed)
 	{
-		Width = newWidth;
-		Height = newHeight;
-		UnsignedCharToImageData(ResizedData, 4);
+		ResizedData = std::shared_ptr<unsigned char>(stbir_resize_uint8_srgb(ImageDataToUnsignedChar().get(), Width, Height, Width * Components, NULL, newWidth, newHeight, newWidth * Components, STBIR_RGBA), free);
+		if (ResizedData)
+		{
+			Width = newWidth;
+			Height = newHeight;
+			UnsignedCharToImageData(ResizedData, 4);
+		}
 	}
-	else 
+	else if (newWidth > 0 && newHeight > 0)
+	{
+		//A trimmed image only resizes its content as a part of the untrimmed image so it comes out the same as resizing the whole image would.
+		//Only the pixels the filter can reach from the content are made, the rest of the resized image would be transparent anyway.
+		//A size of 0 isn't resized at all so it fails the same way as it does for an untrimmed image
+		int NewLeft = 0;
+		int NewRight = 0;
+		int NewTop = 0;
+		int NewBottom = 0;
+		CalculateResizedRange(TrimLeft, Width, UntrimmedWidth, newWidth, NewLeft, NewRight);
+		CalculateResizedRange(TrimTop, Height, UntrimmedHeight, newHeight, NewTop, NewBottom);
+		double WidthScale = static_cast<double>(newWidth) / UntrimmedWidth;
+		double HeightScale = static_cast<double>(newHeight) / UntrimmedHeight;
+
+		//Those pixels are made from a window of the untrimmed image, which is the content with the transparent margin around it that the filter reaches
+		int WindowLeft = std::max(0, static_cast<int>(floor(NewLeft / WidthScale)));
+		int WindowTop = std::max(0, static_cast<int>(floor(NewTop / HeightScale)));
+		int WindowWidth = std::min(UntrimmedWidth, static_cast<int>(ceil(NewRight / WidthScale))) - WindowLeft;
+		int WindowHeight = std::min(UntrimmedHeight, static_cast<int>(ceil(NewBottom / HeightScale))) - WindowTop;
+		if (WindowWidth > 0 && WindowHeight > 0 && NewRight > NewLeft && NewBottom > NewTop)
+		{
+			std::shared_ptr<unsigned char> ContentData = ImageDataToUnsignedChar();
+			std::vector<unsigned char> WindowData(static_cast<size_t>(WindowWidth) * WindowHeight * 4);
+			for (int currentHeight = 0; currentHeight < Height; currentHeight++)
+			{
+				memcpy(WindowData.data() + (static_cast<size_t>(currentHeight + TrimTop - WindowTop) * WindowWidth + TrimLeft - WindowLeft) * 4, ContentData.get() + static_cast<size_t>(currentHeight) * Width * 4, static_cast<size_t>(Width) * 4);
+			}
+
+			//The window is resized with the same scale as the whole image and shifted to the part of the resized image we want
+			ResizedData = std::shared_ptr<unsigned char>(static_cast<unsigned char*>(malloc(static_cast<size_t>(NewRight - NewLeft) * (NewBottom - NewTop) * 4)), free);
+			STBIR_RESIZE Resize;
+			if (ResizedData)
+			{
+				stbir_resize_init(&Resize, WindowData.data(), WindowWidth, WindowHeight, WindowWidth * 4, ResizedData.get(), NewRight - NewLeft, NewBottom - NewTop, (NewRight - NewLeft) * 4, STBIR_RGBA, STBIR_TYPE_UINT8_SRGB);
+				stbir_set_input_subrect(&Resize, (NewLeft / WidthScale - WindowLeft) / WindowWidth, (NewTop / HeightScale - WindowTop) / WindowHeight,
+										(NewRight / WidthScale - WindowLeft) / WindowWidth, (NewBottom / HeightScale - WindowTop) / WindowHeight);
+			}
+
+			if (!ResizedData || !stbir_resize_extended(&Resize))
+			{
+				ResizedData = nullptr;
+			}
+			else
+			{
+				Width = NewRight - NewLeft;
+				Height = NewBottom - NewTop;
+				TrimLeft = NewLeft;
+				TrimTop = NewTop;
+				UntrimmedWidth = newWidth;
+				UntrimmedHeight = newHeight;
+				UnsignedCharToImageData(ResizedData, 4);
+			}
+		}
+	}
+
+	if (!ResizedData) 
 	{
-		printf("Failed to resize Image because %s\n", stbi_failure_reason());
+		printf("Failed to resize Image to %dx%d\n", newWidth, newHeight);
 	}
 }
 
 void Image::ChangeColor(const std::shared_ptr<Pixel> color, const bool& changeAlpha)
 {
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		unsigned char* Data = PackedData.get();
+		for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
+		{
+			if (changeAlpha)
+			{
+				Data[currentPixel * 4 + 3] = static_cast<int>(color->a * 255.0f + 0.5f);
+			}
+
+			//The color has to be premultiplied by the alpha of the pixel, it is rounded like ConvertFormat does
+			//so the pixel is the same as a recolored Float pixel converted to RGBA8
+			float Alpha = Data[currentPixel * 4 + 3];
+			Data[currentPixel * 4] = static_cast<int>(color->r * Alpha + 0.5f);
+			Data[currentPixel * 4 + 1] = static_cast<int>(color->g * Alpha + 0.5f);
+			Data[currentPixel * 4 + 2] = static_cast<int>(color->b * Alpha + 0.5f);
+		}
+
+		if (changeAlpha)
+		{
+			CalculateRowSpans();
+		}
+		return;
+	}
+
 	for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
 	{
-		ImageData.get()[currentPixel].r = color->r;
-		ImageData.get()[currentPixel].g = color->g;
-		ImageData.get()[currentPixel].b = color->b;
 		if (changeAlpha) 
 		{
 			ImageData.get()[currentPixel].a = color->a;
 		}
+
+		//The color has to be premultiplied by the alpha of the pixel
+		float Alpha = ImageData.get()[currentPixel].a;
+		ImageData.get()[currentPixel].r = color->r * Alpha;
+		ImageData.get()[currentPixel].g = color->g * Alpha;
+		ImageData.get()[currentPixel].b = color->b * Alpha;
+	}
+
+	//Only the colors changed when the alpha stays the same so the spans are still correct
+	if (changeAlpha)
+	{
+		CalculateRowSpans();
 	}
 }
 
-//The offset are for the topleft corner where the image will be inserted
-void Image::CompositeImage(const std::shared_ptr<Image> otherImage, const int& widthOffset, const int& heightOffset)
+void Image::CalculateCompositeBounds(const int& otherWidth, const int& otherHeight, const int& widthOffset, const int& heightOffset, int& minimumWidth, int& maxWidth, int& minimumHeight, int& maxHeight)
 {
 	//if the composite image would exceed the bounds of the image cut it off
-	int MaxHeight = 0;
-	if (heightOffset + otherImage->Height >= Height)
+	if (heightOffset + otherHeight >= Height)
 	{
-		MaxHeight = Height - heightOffset;
+		maxHeight = Height - heightOffset;
 	}
 	else
 	{
-		MaxHeight = otherImage->Height;
+		maxHeight = otherHeight;
 	}
 
-	int MinimumHeight = 0;
+	minimumHeight = 0;
 	if (heightOffset < 0) 
 	{
-		MinimumHeight -= heightOffset;
+		minimumHeight -= heightOffset;
 	}
 
-	int MaxWidth = 0;
-	if (widthOffset + otherImage->Width >= Width) 
+	if (widthOffset + otherWidth >= Width) 
 	{
-		MaxWidth = Width - widthOffset;
+		maxWidth = Width - widthOffset;
 	}
 	else 
 	{
-		MaxWidth = otherImage->Width;
+		maxWidth = otherWidth;
 	}
 
-	int MinimumWidth = 0;
+	minimumWidth = 0;
 	if (widthOffset < 0)
 	{
-		MinimumWidth -= widthOffset;
+		minimumWidth -= widthOffset;
 	}
+}
 
-	//To make lines more readable make a currentOtherPixel to store the otherPixel
-	std::shared_ptr<Pixel> currentOtherPixel(new Pixel);
+//The offset are for the topleft corner where the image will be inserted
+void Image::CompositeImage(const std::shared_ptr<Image> otherImage, const int& widthOffset, const int& heightOffset)
+{
+	int MinimumWidth = 0;
+	int MaxWidth = 0;
+	int MinimumHeight = 0;
+	int MaxHeight = 0;
+	CalculateCompositeBounds(otherImage->Width, otherImage->Height, widthOffset, heightOffset, MinimumWidth, MaxWidth, MinimumHeight, MaxHeight);
+
+	//Images of a different format are converted to ours first so the blending only has to deal with one format
+	if (otherImage->Format != Format)
+	{
+		std::shared_ptr<Image> ConvertedImage(new Image());
+		ConvertedImage->CopyValue(otherImage);
+		ConvertedImage->ConvertFormat(Format);
+		CompositeImage(ConvertedImage, widthOffset, heightOffset);
+		return;
+	}
+
+	ScopedTimer Timer(ProfilerStage::StageComposite);
+	bRowSpans = false;
+
+	//Without spans the whole row is blended, otherwise only the parts of the spans that land inside this image
+	long long PixelsComposited = 0;
 	for (int currentHeight = MinimumHeight; currentHeight < MaxHeight; currentHeight++)
 	{
-		for (int currentWidth = MinimumWidth; currentWidth < MaxWidth; currentWidth++)
+		int Row = (currentHeight + heightOffset) * Width + widthOffset;
+		int OtherRow = currentHeight * otherImage->Width;
+		if (!otherImage->bRowSpans)
 		{
-			//If the alpha of the image we are overlaying is 1.0f we can just set the values
-			currentOtherPixel.get()[0] = otherImage->ImageData.get()[currentHeight * otherImage->Width + currentWidth];
-			if (currentOtherPixel->a == 1.0f)
-			{
-				ImageData.get()[(currentHeight + heightOffset) * Width + widthOffset + currentWidth] = currentOtherPixel.get()[0];
-			}
-			else 
+			CompositeRowSection(otherImage, Row + MinimumWidth, OtherRow + MinimumWidth, MaxWidth - MinimumWidth, false);
+			PixelsComposited += std::max(0, MaxWidth - MinimumWidth);
+			continue;
+		}
+
+		for (int currentSpan = otherImage->RowSpanStart[currentHeight]; currentSpan < otherImage->RowSpanStart[currentHeight + 1]; currentSpan++)
+		{
+			const ImageSpan& Span = otherImage->RowSpans[currentSpan];
+			int Start = std::max(Span.Start, MinimumWidth);
+			int End = std::min(Span.End, MaxWidth);
+			if (Start < End)
 			{
-				ImageData.get()[(currentHeight + heightOffset) * Width + widthOffset + currentWidth].Composite(currentOtherPixel.get()[0]);
+				CompositeRowSection(otherImage, Row + Start, OtherRow + Start, End - Start, Span.bOpaque);
+				PixelsComposited += End - Start;
 			}
 		}
 	}
+	Profiler::AddCount(ProfilerCounter::CounterPixelsComposited, PixelsComposited);
+}
+
+void Image::CompositeRowSection(const std::shared_ptr<Image>& otherImage, const int& pixel, const int& otherPixel, const int& count, const bool& bOpaque)
+{
+	//An opaque pixel replaces ours completely which is what blending it would do as well
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		if (bOpaque)
+		{
+			memcpy(PackedData.get() + static_cast<size_t>(pixel) * 4, otherImage->PackedData.get() + static_cast<size_t>(otherPixel) * 4, static_cast<size_t>(count) * 4);
+		}
+		else
+		{
+			PixelKernels::CompositePackedRow(PackedData.get() + static_cast<size_t>(pixel) * 4, otherImage->PackedData.get() + static_cast<size_t>(otherPixel) * 4, count);
+		}
+		return;
+	}
+
+	if (bOpaque)
+	{
+		memcpy(ImageData.get() + pixel, otherImage->ImageData.get() + otherPixel, static_cast<size_t>(count) * sizeof(Pixel));
+	}
+	else
+	{
+		PixelKernels::CompositeRow(ImageData.get() + pixel, otherImage->ImageData.get() + otherPixel, count);
+	}
+}
+
+void Image::CompositeCoverage(const unsigned char* coverage, const int& coverageWidth, const int& coverageHeight, const Pixel& color, const int& widthOffset, const int& heightOffset,
+	const int& coverageStride)
+{
+	int Stride = coverageStride > 0 ? coverageStride : coverageWidth;
+	int MinimumWidth = 0;
+	int MaxWidth = 0;
+	int MinimumHeight = 0;
+	int MaxHeight = 0;
+	CalculateCompositeBounds(coverageWidth, coverageHeight, widthOffset, heightOffset, MinimumWidth, MaxWidth, MinimumHeight, MaxHeight);
+
+	ScopedTimer Timer(ProfilerStage::StageComposite);
+	Profiler::AddCount(ProfilerCounter::CounterPixelsComposited, static_cast<long long>(std::max(0, MaxWidth - MinimumWidth)) * std::max(0, MaxHeight - MinimumHeight));
+	bRowSpans = false;
+
+	for (int currentHeight = MinimumHeight; currentHeight < MaxHeight; currentHeight++)
+	{
+		int Row = (currentHeight + heightOffset) * Width + widthOffset + MinimumWidth;
+		const unsigned char* CoverageRow = coverage + currentHeight * Stride + MinimumWidth;
+		if (Format == PixelFormat::FormatRGBA8)
+		{
+			PixelKernels::CompositePackedCoverageRow(PackedData.get() + Row * 4, CoverageRow, MaxWidth - MinimumWidth, color);
+		}
+		else
+		{
+			PixelKernels::CompositeCoverageRow(ImageData.get() + Row, CoverageRow, MaxWidth - MinimumWidth, color);
+		}
+	}
 }
 
 void Image::CopyValue(const std::shared_ptr<Image> otherImage) 
@@ -169,7 +402,25 @@ void Image::CopyValue(const std::shared_ptr<Image> otherImage)
 	Width = otherImage->Width;
 	Height = otherImage->Height;
 	Components = otherImage->Components;
-	ImageData.reset(new Pixel[Width * Height]);
+	Format = otherImage->Format;
+	bTrimmed = otherImage->bTrimmed;
+	TrimLeft = otherImage->TrimLeft;
+	TrimTop = otherImage->TrimTop;
+	UntrimmedWidth = otherImage->UntrimmedWidth;
+	UntrimmedHeight = otherImage->UntrimmedHeight;
+	RowSpans = otherImage->RowSpans;
+	RowSpanStart = otherImage->RowSpanStart;
+	bRowSpans = otherImage->bRowSpans;
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		ImageData.reset();
+		PackedData.reset(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+		memcpy(PackedData.get(), otherImage->PackedData.get(), static_cast<size_t>(Width) * Height * 4);
+		return;
+	}
+
+	PackedData.reset();
+	ImageData.reset(new Pixel[Width * Height], std::default_delete<Pixel[]>());
 
 	for (int i = 0; i < Width * Height; i++) 
 	{
@@ -180,6 +431,43 @@ void Image::CopyValue(const std::shared_ptr<Image> otherImage)
 	}
 }
 
+void Image::ConvertFormat(const PixelFormat& format)
+{
+	if (format == Format)
+	{
+		return;
+	}
+
+	//Both formats are premultiplied so the channels only have to be scaled
+	if (format == PixelFormat::FormatRGBA8)
+	{
+		PackedData.reset(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+		const float* Channels = &ImageData.get()->r;
+		for (int currentChannel = 0; currentChannel < Width * Height * 4; currentChannel++)
+		{
+			PackedData.get()[currentChannel] = static_cast<int>(Channels[currentChannel] * 255.0f + 0.5f);
+		}
+		ImageData.reset();
+	}
+	else
+	{
+		ImageData.reset(new Pixel[Width * Height], std::default_delete<Pixel[]>());
+		float* Channels = &ImageData.get()->r;
+		for (int currentChannel = 0; currentChannel < Width * Height * 4; currentChannel++)
+		{
+			Channels[currentChannel] = PackedData.get()[currentChannel] / 255.0f;
+		}
+		PackedData.reset();
+	}
+	Format = format;
+
+	//The rounding to unsigned chars can make pixels opaque or transparent that weren't before
+	if (bRowSpans)
+	{
+		CalculateRowSpans();
+	}
+}
+
 void Image::EraseImageSection(const int& sectionWidth, const int& sectionHeight, const int& widthOffset, const int& heightOffset)
 {
 	//Check that we aren't trying to erase outside the image bounds and correct the values if we are
@@ -208,6 +496,16 @@ void Image::EraseImageSection(const int& sectionWidth, const int& sectionHeight,
 	}
 
 	//Go through all the pixels in the section that we want to erase and call reset on the pixels
+	bRowSpans = false;
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		for (int currentHeight = 0; currentHeight < MaxSectionHeight; currentHeight++)
+		{
+			memset(PackedData.get() + ((currentHeight + MinSectionHeight) * Width + MinSectionWidth) * 4, 0, MaxSectionWidth * 4);
+		}
+		return;
+	}
+
 	for (int currentHeight = 0; currentHeight < MaxSectionHeight; currentHeight++)
 	{
 		for (int currentWidth = 0; currentWidth < MaxSectionWidth; currentWidth++)
@@ -245,9 +543,18 @@ std::shared_ptr<Image> Image::CopyImageSection(const int& sectionWidth, const in
 	}
 
 	//Make a CopyImage cariable to copy the section of the image into
-	std::shared_ptr<Image> CopyImage{new Image(sectionWidth, sectionHeight)};
+	std::shared_ptr<Image> CopyImage{new Image(sectionWidth, sectionHeight, Format)};
 
 	//Loop through the section we want to copy and than return it
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		for (int currentHeight = 0; currentHeight < MaxSectionHeight; currentHeight++)
+		{
+			memcpy(CopyImage->PackedData.get() + (currentHeight * MaxSectionWidth) * 4, PackedData.get() + ((currentHeight + MinSectionHeight) * Width + MinSectionWidth) * 4, MaxSectionWidth * 4);
+		}
+		return CopyImage;
+	}
+
 	for (int currentHeight = 0; currentHeight < MaxSectionHeight; currentHeight++)
 	{
 		for (int currentWidth = 0; currentWidth < MaxSectionWidth; currentWidth++)
@@ -260,13 +567,51 @@ std::shared_ptr<Image> Image::CopyImageSection(const int& sectionWidth, const in
 
 void Image::UnsignedCharToImageData(std::shared_ptr<unsigned char> image, const int& components, const bool& bIsText)
 {
-	//Create the pixels for the image
-	ImageData.reset(new Pixel[Width * Height]);
-
 	//Calculate changes since an image can have 1, 2, 3, 4 components and all of them should be convertable
 	int GIncrease = static_cast<int>(floor((components - 1) / 2)) * 1;
 	int BIncrease = static_cast<int>(floor((components - 1) / 2)) * 2;
 	int AIncrease = components - 1;
+
+	//The RGBA8 format only has to expand the data to 4 components
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		PackedData.reset(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+		unsigned char* Data = PackedData.get();
+		for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
+		{
+			if (bIsText)
+			{
+				Data[currentPixel * 4] = 255;
+				Data[currentPixel * 4 + 1] = 255;
+				Data[currentPixel * 4 + 2] = 255;
+			}
+			else
+			{
+				Data[currentPixel * 4] = image.get()[currentPixel * components];
+				Data[currentPixel * 4 + 1] = image.get()[currentPixel * components + GIncrease];
+				Data[currentPixel * 4 + 2] = image.get()[currentPixel * components + BIncrease];
+			}
+
+			if ((components == 1 || components == 3) && !bIsText)
+			{
+				Data[currentPixel * 4 + 3] = 255;
+			}
+			else
+			{
+				//Premultiply the colors now that we know the alpha isn't 255
+				int Alpha = image.get()[currentPixel * components + AIncrease];
+				Data[currentPixel * 4] = DivideBy255(Data[currentPixel * 4] * Alpha);
+				Data[currentPixel * 4 + 1] = DivideBy255(Data[currentPixel * 4 + 1] * Alpha);
+				Data[currentPixel * 4 + 2] = DivideBy255(Data[currentPixel * 4 + 2] * Alpha);
+				Data[currentPixel * 4 + 3] = Alpha;
+			}
+		}
+		CalculateRowSpans();
+		return;
+	}
+
+	//Create the pixels for the image
+	ImageData.reset(new Pixel[Width * Height], std::default_delete<Pixel[]>());
 	
 	//Go through every pixel and assign the value
 	for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
@@ -291,23 +636,151 @@ void Image::UnsignedCharToImageData(std::shared_ptr<unsigned char> image, const
 		}
 		else 
 		{
-			ImageData.get()[currentPixel].a = image.get()[currentPixel * components + AIncrease] / 255.0f;
+			//Premultiply the colors now that we know the alpha isn't 1
+			float Alpha = image.get()[currentPixel * components + AIncrease] / 255.0f;
+			ImageData.get()[currentPixel].r *= Alpha;
+			ImageData.get()[currentPixel].g *= Alpha;
+			ImageData.get()[currentPixel].b *= Alpha;
+			ImageData.get()[currentPixel].a = Alpha;
+		}
+	}
+	CalculateRowSpans();
+}
+
+void Image::TrimTransparentMargins()
+{
+	if (Width == 0 || Height == 0)
+	{
+		return;
+	}
+
+	//The spans of a row start at the first pixel that isn't transparent and end after the last one so they give the bounds right away
+	if (!bRowSpans)
+	{
+		CalculateRowSpans();
+	}
+
+	int Left = Width;
+	int Top = Height;
+	int Right = 0;
+	int Bottom = 0;
+	for (int currentHeight = 0; currentHeight < Height; currentHeight++)
+	{
+		if (RowSpanStart[currentHeight] == RowSpanStart[currentHeight + 1])
+		{
+			continue;
+		}
+
+		Left = std::min(Left, RowSpans[RowSpanStart[currentHeight]].Start);
+		Right = std::max(Right, RowSpans[RowSpanStart[currentHeight + 1] - 1].End);
+		Top = std::min(Top, currentHeight);
+		Bottom = currentHeight + 1;
+	}
+
+	//A completely transparent image keeps a single pixel so it can still be resized
+	if (Right == 0)
+	{
+		Left = 0;
+		Top = 0;
+		Right = 1;
+		Bottom = 1;
+	}
+
+	if (Left == 0 && Top == 0 && Right == Width && Bottom == Height)
+	{
+		return;
+	}
+
+	std::shared_ptr<Image> Content = CopyImageSection(Right - Left, Bottom - Top, Left, Top);
+	UntrimmedWidth = GetUntrimmedWidth();
+	UntrimmedHeight = GetUntrimmedHeight();
+	TrimLeft += Left;
+	TrimTop += Top;
+	bTrimmed = true;
+	Width = Content->Width;
+	Height = Content->Height;
+	//The pixels are moved out of the section since its destructor would reset them otherwise
+	ImageData = std::move(Content->ImageData);
+	PackedData = std::move(Content->PackedData);
+	CalculateRowSpans();
+}
+
+void Image::CalculateRowSpans()
+{
+	//Opaque runs and gaps of transparent pixels that are shorter than this are blended with the pixels around them,
+	//a lot of tiny spans would cost more than blending the few pixels would
+	const int MinimumRun = 8;
+
+	RowSpans.clear();
+	RowSpanStart.assign(Height + 1, 0);
+	for (int currentHeight = 0; currentHeight < Height; currentHeight++)
+	{
+		RowSpanStart[currentHeight] = static_cast<int>(RowSpans.size());
+		int currentWidth = 0;
+		while (currentWidth < Width)
+		{
+			//Find the run of pixels that are all transparent, all opaque or all in between
+			int RunStart = currentWidth;
+			int Alpha = GetAlphaClass(currentHeight * Width + currentWidth);
+			while (currentWidth < Width && GetAlphaClass(currentHeight * Width + currentWidth) == Alpha)
+			{
+				currentWidth++;
+			}
+
+			bool bLongRun = currentWidth - RunStart >= MinimumRun;
+			if (Alpha == 0 && (bLongRun || RunStart == 0 || currentWidth == Width))
+			{
+				continue;
+			}
+
+			if (Alpha == 2 && bLongRun)
+			{
+				RowSpans.push_back(ImageSpan{ RunStart, currentWidth, true });
+			}
+			else if (RowSpans.size() > static_cast<size_t>(RowSpanStart[currentHeight]) && !RowSpans.back().bOpaque && RowSpans.back().End == RunStart)
+			{
+				RowSpans.back().End = currentWidth;
+			}
+			else
+			{
+				RowSpans.push_back(ImageSpan{ RunStart, currentWidth, false });
+			}
 		}
 	}
+	RowSpanStart[Height] = static_cast<int>(RowSpans.size());
+	bRowSpans = true;
 }
 
 std::shared_ptr<unsigned char> Image::ImageDataToUnsignedChar()
 {
 	//Make all the empty unsigned chars for this image
-	std::shared_ptr<unsigned char> tempImage(new unsigned char[Width * Height * Components]);
+	std::shared_ptr<unsigned char> tempImage(new unsigned char[Width * Height * Components], std::default_delete<unsigned char[]>());
 	
-	//Go through every pixel and convert them back into unsigned chars which we return
+	//The RGBA8 format only has to undo the premultiplied alpha
+	if (Format == PixelFormat::FormatRGBA8)
+	{
+		const unsigned char* Data = PackedData.get();
+		for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++)
+		{
+			int Alpha = Data[currentPixel * 4 + 3];
+			for (int channel = 0; channel < 3; channel++)
+			{
+				tempImage.get()[currentPixel * 4 + channel] = Alpha == 0 ? 0 : std::min(255, (Data[currentPixel * 4 + channel] * 255 + Alpha / 2) / Alpha);
+			}
+			tempImage.get()[currentPixel * 4 + 3] = Alpha;
+		}
+		return tempImage;
+	}
+
+	//Go through every pixel, undo the premultiplied alpha and convert them back into unsigned chars which we return
 	for (int currentPixel = 0; currentPixel < Width * Height; currentPixel++) 
 	{
-		tempImage.get()[currentPixel * 4] = static_cast<int>(ImageData.get()[currentPixel].r * 255.0f);
-		tempImage.get()[currentPixel * 4 + 1] = static_cast<int>(ImageData.get()[currentPixel].g * 255.0f);
-		tempImage.get()[currentPixel * 4 + 2] = static_cast<int>(ImageData.get()[currentPixel].b * 255.0f);
-		tempImage.get()[currentPixel * 4 + 3] = static_cast<int>(ImageData.get()[currentPixel].a * 255.0f);
+		const Pixel& CurrentPixel = ImageData.get()[currentPixel];
+		float InverseAlpha = CurrentPixel.a > 0.0f ? 1.0f / CurrentPixel.a : 0.0f;
+		tempImage.get()[currentPixel * 4] = static_cast<int>(std::min(CurrentPixel.r * InverseAlpha, 1.0f) * 255.0f + 0.5f);
+		tempImage.get()[currentPixel * 4 + 1] = static_cast<int>(std::min(CurrentPixel.g * InverseAlpha, 1.0f) * 255.0f + 0.5f);
+		tempImage.get()[currentPixel * 4 + 2] = static_cast<int>(std::min(CurrentPixel.b * InverseAlpha, 1.0f) * 255.0f + 0.5f);
+		tempImage.get()[currentPixel * 4 + 3] = static_cast<int>(CurrentPixel.a * 255.0f + 0.5f);
 	}
 	return tempImage;
 }
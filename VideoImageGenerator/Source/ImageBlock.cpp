@@ -1,4 +1,6 @@
 #include "../Header/ImageBlock.h"
+#include "../Header/AssetCache.h"
+#include "../Header/Profiler.h"
 
 ImageBlock::ImageBlock(const std::string& name, const int& widthOffset, const int& heightOffset, const Alignment& blockAlignment, const SnapAlignment& snapSide, const int& width, const int& height)
 	: BaseBlock(name, widthOffset, heightOffset, width, height, blockAlignment, snapSide)
@@ -21,59 +23,84 @@ ImageBlock::~ImageBlock()
 
 int ImageBlock::GetDataWidth()
 {
-	return StoredImage->GetWidth();
+	return GetCurrentImage()->GetUntrimmedWidth();
 }
 
 int ImageBlock::GetDataHeight()
 {
-	return StoredImage->GetHeight();
+	return GetCurrentImage()->GetUntrimmedHeight();
 }
 
-void ImageBlock::SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font)
+bool ImageBlock::PrepareData(const std::shared_ptr<Font>& /*font*/)
 {
-	if (StoredImage != nullptr)
+	if (StoredImage == nullptr)
 	{
-		//Resize the image based on the parameters we want
-		if (bRetainAspectRatio)
+		printf("There was no image given to save for Block: %s.\n", Name.c_str());
+		return false;
+	}
+
+	//The StoredImage can be shared with other blocks through the AssetCache so it can't be changed, if it needs to be resized a copy is made first
+	ResizedImage = StoredImage;
+	bool bResize = !bRetainAspectRatio || (Width != 0 && Width != StoredImage->GetUntrimmedWidth()) || (Height != 0 && Height != StoredImage->GetUntrimmedHeight());
+	if (!bResize)
+	{
+		return true;
+	}
+
+	//Blocks with the same image and size can use the image that has been resized before
+	ResizedImage = AssetCache::FindResizedImage(StoredImage, Width, Height, bRetainAspectRatio);
+	if (ResizedImage != nullptr)
+	{
+		return true;
+	}
+	ScopedTimer Timer(ProfilerStage::StageResize);
+	CopyStoredImage();
+
+	//Resize the image based on the parameters we want
+	if (bRetainAspectRatio)
+	{
+		if (Width != 0 && Width != ResizedImage->GetUntrimmedWidth())
 		{
-			if (Width != 0 && Width != StoredImage->GetWidth())
-			{
-				StoredImage->ResizeImageWidth(Width);
-				if (Height != 0 && Height < StoredImage->GetHeight())
-				{
-					StoredImage->ResizeImageHeight(Height);
-				}
-			}
-			else if (Height != 0 && Height != StoredImage->GetHeight())
+			ResizedImage->ResizeImageWidth(Width);
+			if (Height != 0 && Height < ResizedImage->GetUntrimmedHeight())
 			{
-				StoredImage->ResizeImageHeight(Height);
-				if (Width != 0 && Width < StoredImage->GetWidth())
-				{
-					StoredImage->ResizeImageWidth(Width);
-				}
+				ResizedImage->ResizeImageHeight(Height);
 			}
 		}
 		else
 		{
-			StoredImage->ResizeImage(Width, Height);
+			ResizedImage->ResizeImageHeight(Height);
+			if (Width != 0 && Width < ResizedImage->GetUntrimmedWidth())
+			{
+				ResizedImage->ResizeImageWidth(Width);
+			}
 		}
-
-		//Calculate the position from which we neeed to add the image
-		int ImageWidthOffset = CalculateWidthOffset() - CalculateWidthAlignment();
-		int ImageHeightOffset = CalculateHeightOffset() - CalculateHeightAlignment();
-		CalculateAndAddSnapCorrection(ImageWidthOffset, ImageHeightOffset);
-		image->CompositeImage(StoredImage, ImageWidthOffset, ImageHeightOffset);
 	}
 	else
 	{
-		printf("There was no image given to save for Block: %s.\n", Name.c_str());
+		ResizedImage->ResizeImage(Width, Height);
 	}
 
-	BaseBlock::SaveImage(image, font);
+	AssetCache::AddResizedImage(StoredImage, Width, Height, bRetainAspectRatio, ResizedImage);
+	return true;
+}
+
+void ImageBlock::DrawData(const std::shared_ptr<Image>& image, const int& widthOffset, const int& heightOffset)
+{
+	//A trimmed image only has the pixels of its content so they are moved to where the content was
+	image->CompositeImage(ResizedImage, widthOffset + ResizedImage->GetTrimLeft(), heightOffset + ResizedImage->GetTrimTop());
+}
+
+void ImageBlock::CopyStoredImage()
+{
+	ResizedImage = std::shared_ptr<Image>(new Image());
+	ResizedImage->CopyValue(StoredImage);
 }
 
 void ImageBlock::ClearData()
 {
 	StoredImage = nullptr;
+	ResizedImage = nullptr;
+	bRetainAspectRatio = true;
 	BaseBlock::ClearData();
 }
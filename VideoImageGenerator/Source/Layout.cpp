@@ -1,12 +1,21 @@
 #include "../Header/Layout.h"
 #include <filesystem>
+#include <thread>
+#include "../Header/Profiler.h"
 
-Layout::Layout(const nlohmann::json& JData)
+Layout::Layout(const nlohmann::json& JData, const LayoutSettings& settings)
 {
+	Settings = settings;
 	Initialize(JData.at("Layout"));
 	GoThroughData(JData.at("Images"));
 }
 
+Layout::Layout(std::istream& stream, const LayoutSettings& settings)
+{
+	Settings = settings;
+	StreamData(stream);
+}
+
 Layout::~Layout()
 {
 
@@ -19,12 +28,20 @@ void Layout::Initialize(const nlohmann::json& JData)
 	{
 		SaveFilePath = JData.at("SaveFilePath");
 	}
-	else
+	else if (Settings.Writer == nullptr)
 	{
-		SaveFilePath = std::filesystem::current_path().string() + "\\";
+		SaveFilePath = (std::filesystem::current_path() / "").string();
 		printf("The json doesn't contain a filepath to save to so it will defualt to the working directory which is: %s.\n", SaveFilePath.c_str());
 	}
 
+	if (JData.contains("PixelFormat"))
+	{
+		ImageFormat = JData.at("PixelFormat");
+	}
+
+	bTrimImages = Settings.bTrimImages || (JData.contains("TrimImages") && JData.at("TrimImages") == true);
+	bSDFText = Settings.bSDFText || (JData.contains("SDFText") && JData.at("SDFText") == true);
+
 	//We return here because if no size is given we can't estimate what size they might want and since this isn't dynamic yet
 	if (JData.contains("Background Image"))
 	{
@@ -34,7 +51,7 @@ void Layout::Initialize(const nlohmann::json& JData)
 	{
 		if (JData.contains("Width") && JData.contains("Height"))
 		{
-			SetBackgroundImage(std::shared_ptr<Image>{new Image(JData.at("Width"), JData.at("height"))});
+			SetBackgroundImage(std::shared_ptr<Image>{new Image(JData.at("Width"), JData.at("height"), ImageFormat)});
 		}
 		else
 		{
@@ -43,12 +60,9 @@ void Layout::Initialize(const nlohmann::json& JData)
 		}
 	}
 
-	//Initialize the Canvas which all the blocks will be added onto
-	Canvas = std::shared_ptr<BaseBlock>(new BaseBlock("Canvas", 0, 0, BackgroundImage->GetWidth(), BackgroundImage->GetHeight()));
-
 	if (JData.contains("Font"))
 	{
-		SetFont(std::shared_ptr<Font>{new Font(JData.at("Font"))});
+		SetFont(std::shared_ptr<Font>{new Font(JData.at("Font"), bSDFText)});
 	}
 
 	if (JData.contains("BottomBottomDistanceFromLowestLayoutBlock"))
@@ -61,36 +75,652 @@ void Layout::Initialize(const nlohmann::json& JData)
 		BottomHeight = JData.at("BottomHeight");
 	}
 
-	AddPotentialLayouts(JData, Canvas);
+	//The budget is given in megabytes and is shared by every layout as they all use the same AssetCache
+	if (JData.contains("AssetCacheBudget"))
+	{
+		AssetCache::SetMemoryBudget(static_cast<size_t>(JData.at("AssetCacheBudget")) * 1024 * 1024);
+	}
+
+	//A Threads value of 0 will use every core, the settings take priority over the json
+	if (Settings.Threads >= 0)
+	{
+		Threads = Settings.Threads;
+	}
+	else if (JData.contains("Threads"))
+	{
+		Threads = JData.at("Threads");
+	}
+
+	if (Threads < 1)
+	{
+		Threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+
+	//Every image that is being encoded splits its compression over the cores that aren't already encoding another image.
+	//The encoder settings are kept by the layout so other layouts using different ones at the same time don't change them
+	if (Settings.CompressionLevel >= 0)
+	{
+		CompressionLevel = std::clamp(Settings.CompressionLevel, 0, 9);
+	}
+	else if (JData.contains("CompressionLevel"))
+	{
+		CompressionLevel = std::clamp(JData.at("CompressionLevel").get<int>(), 0, 9);
+	}
+
+	if (JData.contains("EncodeThreads"))
+	{
+		EncodeThreads = std::max(0, JData.at("EncodeThreads").get<int>());
+	}
+	else
+	{
+		EncodeThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / Threads);
+	}
+
+	LayoutJData = JData;
+	Canvas = MakeCanvas(JData);
+}
+
+std::shared_ptr<BaseBlock> Layout::MakeCanvas(const nlohmann::json& JData)
+{
+	//Initialize the Canvas which all the blocks will be added onto
+	std::shared_ptr<BaseBlock> NewCanvas(new BaseBlock("Canvas", 0, 0, BackgroundImage->GetWidth(), BackgroundImage->GetHeight()));
+
+	AddPotentialLayouts(JData, NewCanvas);
 
 	if (JData.contains("Blocks"))
 	{
 		nlohmann::json Blocks = JData.at("Blocks");
 		for (int i = 0; i < Blocks.size(); i++)
 		{
-			AddBlock(Blocks[i]);
+			AddBlock(Blocks[i], NewCanvas);
 		}
 	}
+
+	MarkStaticBlocks(NewCanvas, "", false);
+	return NewCanvas;
 }
 
 void Layout::GoThroughData(const nlohmann::json& JData) 
 {
-	//We go though all of the imagedata and save the images
-	std::string Filename = "";
+	//The Canvas is only missing when the layout failed to initialize
+	if (Canvas == nullptr)
+	{
+		return;
+	}
+
+	//Pick the images that belong to this shard, the index in the Images list is used so every process makes the same choice
+	Frames.clear();
 	for (int i = 0; i < JData.size(); i++)
 	{
-		Filename = JData[i].at("Filename");
+		if (i % Settings.ShardCount == Settings.ShardIndex)
+		{
+			Frames.push_back(i);
+		}
+	}
 
-		nlohmann::json Data = JData[i].at("Data");
-		for (int i = 0; i < Data.size(); i++)
+	RenderBatch(JData);
+}
+
+void Layout::StreamData(std::istream& stream)
+{
+	bool bHasLayout = false;
+	bool bHasImages = false;
+	int ImageIndex = 0;
+	std::string CurrentKey = "";
+	nlohmann::json Batch = nlohmann::json::array();
+
+	//The parse time is everything between the batches since the rendering happens inside of the parse
+	std::chrono::steady_clock::time_point ParseStart = std::chrono::steady_clock::now();
+	auto RenderStreamBatch = [&]()
+	{
+		Profiler::AddStageTime(ProfilerStage::StageParse, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ParseStart).count());
+
+		Frames.clear();
+		for (int i = 0; i < Batch.size(); i++)
+		{
+			Frames.push_back(i);
+		}
+		RenderBatch(Batch);
+
+		Batch = nlohmann::json::array();
+		ParseStart = std::chrono::steady_clock::now();
+	};
+
+	//The depth is 1 for the keys and values of the root object and 2 for the entries of the Images list.
+	//Returning false makes the parser throw the value away so the images that are taken out don't stay in the result
+	nlohmann::json::parser_callback_t Callback = [&](int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed)
+	{
+		if (depth == 1 && event == nlohmann::json::parse_event_t::key)
+		{
+			CurrentKey = parsed;
+			bHasImages = bHasImages || CurrentKey == "Images";
+		}
+		else if (depth == 1 && event == nlohmann::json::parse_event_t::object_end && CurrentKey == "Layout" && !bHasLayout)
+		{
+			Initialize(parsed);
+			bHasLayout = true;
+		}
+		else if (depth == 2 && event == nlohmann::json::parse_event_t::object_end && CurrentKey == "Images" && bHasLayout)
+		{
+			if (ImageIndex++ % Settings.ShardCount == Settings.ShardIndex && Canvas != nullptr)
+			{
+				Batch.push_back(std::move(parsed));
+				if (Batch.size() >= (Settings.BatchSize > 0 ? Settings.BatchSize : Threads * 4))
+				{
+					RenderStreamBatch();
+				}
+			}
+			return false;
+		}
+		return true;
+	};
+
+	nlohmann::json JData = nlohmann::json::parse(stream, Callback, false);
+	if (!Batch.empty())
+	{
+		RenderStreamBatch();
+	}
+	else
+	{
+		Profiler::AddStageTime(ProfilerStage::StageParse, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - ParseStart).count());
+	}
+
+	if (JData.is_discarded() || !bHasLayout || !bHasImages)
+	{
+		bValid = false;
+		return;
+	}
+
+	//Images that came before the Layout couldn't be rendered while they were read so they are still in the result
+	if (JData.contains("Images") && JData.at("Images").is_array() && !JData.at("Images").empty())
+	{
+		printf("The Images came before the Layout in the json so they all had to be read before rendering, put the Layout first to stream them.\n");
+		GoThroughData(JData.at("Images"));
+	}
+}
+
+void Layout::RenderBatch(const nlohmann::json& JData)
+{
+	//The Canvas is only missing when the layout failed to initialize
+	if (Canvas == nullptr)
+	{
+		return;
+	}
+
+	if (Settings.bStaticLayer)
+	{
+		PrepareStaticLayer(JData);
+	}
+
+	//The frames are given their place in the stream before any of them are rendered so they keep the order of the Images list
+	if (Settings.Writer != nullptr && !Frames.empty())
+	{
+		FirstStreamFrame = Settings.Writer->ReserveFrames(static_cast<int>(Frames.size()), BackgroundImage->GetWidth(), BackgroundImage->GetHeight());
+	}
+
+	if (Settings.bPipeline && !Frames.empty())
+	{
+		RenderPipeline(JData);
+		return;
+	}
+
+	NextFrame = 0;
+	if (Threads <= 1 || Frames.size() <= 1)
+	{
+		RenderFrames(JData, Canvas);
+		return;
+	}
+
+	//Every image is rendered on its own so the threads just take the next one that hasn't been taken yet, the first thread reuses the Canvas
+	std::vector<std::thread> Workers;
+	int WorkerCount = std::min(Threads, static_cast<int>(Frames.size()));
+	while (WorkerCanvases.size() < WorkerCount - 1)
+	{
+		WorkerCanvases.push_back(MakeCanvas(LayoutJData));
+	}
+
+	for (int i = 1; i < WorkerCount; i++)
+	{
+		std::shared_ptr<BaseBlock> WorkerCanvas = WorkerCanvases[i - 1];
+		Workers.push_back(std::thread([this, &JData, WorkerCanvas]() { RenderFrames(JData, WorkerCanvas); }));
+	}
+
+	RenderFrames(JData, Canvas);
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+}
+
+void Layout::RenderPipeline(const nlohmann::json& JData)
+{
+	//The assets of the next images are decoded while the current ones are composed and the ones before that are encoded.
+	//The Threads value is the amount of images that are composed and the amount that are encoded at the same time,
+	//the queues hold 2 images per thread so the decoding is at most that far ahead and only that many finished images wait to be encoded
+	int WorkerCount = std::min(Threads, static_cast<int>(Frames.size()));
+	BoundedQueue<std::shared_ptr<PipelineFrame>> ComposeQueue(WorkerCount * 2);
+	BoundedQueue<std::shared_ptr<PipelineFrame>> EncodeQueue(WorkerCount * 2);
+	while (WorkerCanvases.size() < WorkerCount - 1)
+	{
+		WorkerCanvases.push_back(MakeCanvas(LayoutJData));
+	}
+
+	//The frames can be finished out of order so the Writer holds them back until it is their turn, the decoding isn't allowed to get further ahead
+	//of the Writer than the frames that fit in the pipeline so the frames that are held back can't pile up behind a slow one
+	int StreamWindow = static_cast<int>(ComposeQueue.GetCapacity() + EncodeQueue.GetCapacity()) + WorkerCount * 2;
+	std::thread PrefetchWorker([this, &JData, &ComposeQueue, StreamWindow]()
+		{
+			for (int i = 0; i < Frames.size(); i++)
+			{
+				if (Settings.Writer != nullptr)
+				{
+					Settings.Writer->WaitForWindow(FirstStreamFrame + i, StreamWindow);
+				}
+
+				//An image with data that can't be used is dropped here so it never reaches the other stages
+				std::shared_ptr<PipelineFrame> Frame(new PipelineFrame());
+				Frame->Index = Frames[i];
+				Frame->StreamIndex = FirstStreamFrame + i;
+				try
+				{
+					Frame->Filename = JData[Frame->Index].at("Filename");
+
+					Profiler::BeginFrame(Frame->Filename);
+					std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+					PrefetchAssets(JData[Frame->Index].at("Data"), Frame->Assets);
+					Frame->FrameNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+					Frame->Report = Profiler::SuspendFrame();
+				}
+				catch (const std::exception& Exception)
+				{
+					SkipFrame(Frame->StreamIndex, Exception);
+					continue;
+				}
+
+				ComposeQueue.Push(Frame);
+			}
+			ComposeQueue.Close();
+		});
+
+	std::vector<std::thread> ComposeWorkers;
+	for (int i = 0; i < WorkerCount; i++)
+	{
+		std::shared_ptr<BaseBlock> WorkerCanvas = i == 0 ? Canvas : WorkerCanvases[i - 1];
+		ComposeWorkers.push_back(std::thread([this, &JData, &ComposeQueue, &EncodeQueue, WorkerCanvas]()
+			{
+				std::shared_ptr<PipelineFrame> Frame;
+				while (ComposeQueue.Pop(Frame))
+				{
+					Profiler::ResumeFrame(Frame->Report);
+					std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+					try
+					{
+						nlohmann::json Data = JData[Frame->Index].at("Data");
+						for (int i = 0; i < Data.size(); i++)
+						{
+							AddData(Data[i], WorkerCanvas);
+						}
+
+						Frame->Result = ComposeImage(WorkerCanvas);
+					}
+					catch (const std::exception& Exception)
+					{
+						WorkerCanvas->ClearData();
+						SkipFrame(Frame->StreamIndex, Exception);
+						continue;
+					}
+					WorkerCanvas->ClearData();
+					Frame->Assets.clear();
+					Frame->FrameNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+					Frame->Report = Profiler::SuspendFrame();
+
+					EncodeQueue.Push(Frame);
+				}
+			}));
+	}
+
+	std::vector<std::thread> EncodeWorkers;
+	for (int i = 0; i < WorkerCount; i++)
+	{
+		EncodeWorkers.push_back(std::thread([this, &EncodeQueue]()
+			{
+				std::shared_ptr<PipelineFrame> Frame;
+				while (EncodeQueue.Pop(Frame))
+				{
+					Profiler::ResumeFrame(Frame->Report);
+					std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+					if (Settings.Writer != nullptr)
+					{
+						Settings.Writer->WriteFrame(Frame->StreamIndex, Frame->Result);
+					}
+					else
+					{
+						Frame->Result->SaveImage(SaveFilePath + Frame->Filename + ".png", CompressionLevel, EncodeThreads);
+						printf("Image saved to: %s as: %s.png\n", SaveFilePath.c_str(), Frame->Filename.c_str());
+					}
+					Frame->FrameNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+
+					if (Profiler::IsEnabled())
+					{
+						Profiler::AddStageTime(ProfilerStage::StageFrame, Frame->FrameNanoseconds);
+					}
+					Profiler::EndFrame();
+				}
+			}));
+	}
+
+	//The encoders can only stop once every composer is done as any of them can still add an image
+	PrefetchWorker.join();
+	for (std::thread& Worker : ComposeWorkers)
+	{
+		Worker.join();
+	}
+	EncodeQueue.Close();
+	for (std::thread& Worker : EncodeWorkers)
+	{
+		Worker.join();
+	}
+}
+
+void Layout::RenderFrames(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas)
+{
+	for (int i = NextFrame++; i < Frames.size(); i = NextFrame++)
+	{
+		//The threads take the frames in order so the thread with the frame the Writer needs next never has to wait
+		if (Settings.Writer != nullptr)
+		{
+			Settings.Writer->WaitForWindow(FirstStreamFrame + i, Threads * 2);
+		}
+		RenderFrame(JData[Frames[i]], canvas, FirstStreamFrame + i);
+	}
+}
+
+void Layout::RenderFrame(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const int& streamIndex)
+{
+	//An image with data that can't be used is skipped like an invalid layout file so the other images still get rendered,
+	//nothing would catch the exception on the threads
+	try
+	{
+		//Add the data of the image to the blocks, save it and clear the blocks so they can be used for the next image
+		std::string Filename = JData.at("Filename");
+		Profiler::BeginFrame(Filename);
+		{
+			ScopedTimer Timer(ProfilerStage::StageFrame);
+			nlohmann::json Data = JData.at("Data");
+			for (int i = 0; i < Data.size(); i++)
+			{
+				AddData(Data[i], canvas);
+			}
+
+			if (Settings.Writer != nullptr)
+			{
+				Settings.Writer->WriteFrame(streamIndex, ComposeImage(canvas));
+			}
+			else
+			{
+				ComposeImage(canvas)->SaveImage(SaveFilePath + Filename + ".png", CompressionLevel, EncodeThreads);
+				printf("Image saved to: %s as: %s.png\n", SaveFilePath.c_str(), Filename.c_str());
+			}
+
+			canvas->ClearData();
+		}
+		Profiler::EndFrame();
+	}
+	catch (const std::exception& Exception)
+	{
+		canvas->ClearData();
+		SkipFrame(streamIndex, Exception);
+	}
+}
+
+void Layout::SkipFrame(const int& streamIndex, const std::exception& exception)
+{
+	//The frame is left out of the report and its place in the stream is given up so the frames after it are still written
+	printf("An image couldn't be rendered and was skipped: %s\n", exception.what());
+	Profiler::SuspendFrame();
+	if (Settings.Writer != nullptr)
+	{
+		Settings.Writer->SkipFrame(streamIndex);
+	}
+}
+
+void Layout::PrefetchAssets(const nlohmann::json& JData, std::vector<std::shared_ptr<Image>>& assets)
+{
+	//Files that don't exist are left to the block so the error is only printed once
+	if (JData.is_object() && JData.contains("StoredImage") && JData.at("StoredImage").is_string())
+	{
+		std::string Filename = JData.at("StoredImage");
+		if (std::filesystem::exists(Filename))
+		{
+			assets.push_back(AssetCache::GetImage(Filename, ImageFormat, bTrimImages));
+		}
+	}
+
+	if (JData.is_structured())
+	{
+		for (const nlohmann::json& Value : JData)
+		{
+			PrefetchAssets(Value, assets);
+		}
+	}
+}
+
+void Layout::PrepareStaticLayer(const nlohmann::json& JData)
+{
+	//Find the data every block gets in the first image and the blocks that get different data in any of the other images,
+	//a block that only gets data in some of the images is different as well. A single image has nothing to share the layer with.
+	//Images without a Data list are skipped when they are rendered so they don't count
+	std::vector<int> DataFrames;
+	for (int Frame : Frames)
+	{
+		if (JData[Frame].is_object() && JData[Frame].contains("Data") && JData[Frame].at("Data").is_array())
+		{
+			DataFrames.push_back(Frame);
+		}
+	}
+
+	std::map<std::string, nlohmann::json> BlockData;
+	std::set<std::string> VaryingBlocks;
+	std::set<std::string> NewStaticBlocks;
+	if (DataFrames.size() > 1)
+	{
+		CollectBlockData(JData[DataFrames[0]].at("Data"), "", BlockData);
+		for (int i = 1; i < DataFrames.size(); i++)
+		{
+			std::map<std::string, nlohmann::json> FrameData;
+			CollectBlockData(JData[DataFrames[i]].at("Data"), "", FrameData);
+			for (const std::pair<const std::string, nlohmann::json>& Data : FrameData)
+			{
+				std::map<std::string, nlohmann::json>::const_iterator FirstData = BlockData.find(Data.first);
+				if (FirstData == BlockData.end() || FirstData->second != Data.second)
+				{
+					VaryingBlocks.insert(Data.first);
+				}
+			}
+			for (const std::pair<const std::string, nlohmann::json>& Data : BlockData)
+			{
+				if (FrameData.find(Data.first) == FrameData.end())
+				{
+					VaryingBlocks.insert(Data.first);
+				}
+			}
+		}
+
+		bool bVaryingDrawn = false;
+		FindStaticBlocks(Canvas, "", BlockData, VaryingBlocks, bVaryingDrawn, NewStaticBlocks);
+	}
+
+	//The data of the static blocks decides what the layer looks like, when it is the same as the last batch the layer can be used again
+	nlohmann::json NewStaticBlockData = nlohmann::json::object();
+	for (const std::pair<const std::string, nlohmann::json>& Data : BlockData)
+	{
+		for (const std::string& StaticBlock : NewStaticBlocks)
+		{
+			if (Data.first == StaticBlock || Data.first.rfind(StaticBlock + "/", 0) == 0)
+			{
+				NewStaticBlockData[Data.first] = Data.second;
+				break;
+			}
+		}
+	}
+
+	if (NewStaticBlocks == StaticBlocks && NewStaticBlockData == StaticBlockData)
+	{
+		return;
+	}
+
+	//The static blocks are drawn the same way ComposeImage would, only the plan is compiled without any of the blocks being static.
+	//They come before any block that is drawn for every image so starting from the layer gives the same result as drawing them every time
+	StaticBlocks.clear();
+	MarkStaticBlocks(Canvas, "", false);
+	StaticLayer = nullptr;
+	StaticBackground = nullptr;
+	StaticLowestHeight = 0;
+	ResetStaticBounds();
+	if (!NewStaticBlocks.empty())
+	{
+		//When the data can't be added the image is skipped later on and the batch is rendered without a layer
+		bool bDataAdded = true;
+		nlohmann::json Data = JData[DataFrames[0]].at("Data");
+		try
+		{
+			for (int i = 0; i < Data.size(); i++)
+			{
+				AddData(Data[i], Canvas);
+			}
+		}
+		catch (const std::exception&)
+		{
+			Canvas->ClearData();
+			NewStaticBlockData = nlohmann::json::object();
+			bDataAdded = false;
+		}
+
+		if (bDataAdded)
+		{
+			std::vector<RenderItem> RenderPlan;
+			Canvas->CompileRenderPlan(RenderPlan, TextFont);
+
+			StaticBlocks = NewStaticBlocks;
+			MarkStaticBlocks(Canvas, "", false);
+			StaticLayer = std::shared_ptr<Image>(new Image(BackgroundImage->GetWidth(), BackgroundImage->GetHeight(), ImageFormat));
+
+			//The images that aren't cropped draw their blocks straight onto the background, so the static blocks are drawn onto a copy of it as well.
+			//Compositing the finished StaticLayer onto the background would round differently than drawing the blocks one by one
+			StaticBackground = std::shared_ptr<Image>(new Image());
+			StaticBackground->CopyValue(BackgroundImage);
+			for (const RenderItem& Item : RenderPlan)
+			{
+				if (!Item.Block->IsStatic())
+				{
+					continue;
+				}
+
+				if (Item.bDraw)
+				{
+					Item.Block->DrawData(StaticLayer, Item.WidthOffset, Item.HeightOffset);
+					Item.Block->DrawData(StaticBackground, Item.WidthOffset, Item.HeightOffset);
+				}
+				AddToBounds(Item, StaticLayer->GetWidth(), StaticLayer->GetHeight(), StaticLeft, StaticTop, StaticRight, StaticBottom);
+
+				if (Item.BottomHeight > StaticLowestHeight)
+				{
+					StaticLowestHeight = Item.BottomHeight;
+				}
+			}
+			Canvas->ClearData();
+		}
+	}
+	StaticBlockData = NewStaticBlockData;
+
+	for (const std::shared_ptr<BaseBlock>& WorkerCanvas : WorkerCanvases)
+	{
+		MarkStaticBlocks(WorkerCanvas, "", false);
+	}
+}
+
+void Layout::CollectBlockData(const nlohmann::json& JData, const std::string& path, std::map<std::string, nlohmann::json>& blockData)
+{
+	//The data of a block is stored without the data of its linked blocks since those are collected on their own.
+	//A block can be given data more than once in an image so every block gets a list
+	for (const nlohmann::json& Data : JData)
+	{
+		if (!Data.is_object() || !Data.contains("Name") || !Data.at("Name").is_string())
 		{
-			AddData(Data[i]);
+			continue;
 		}
 
-		SaveImage(SaveFilePath + Filename + ".png");
-		printf("Image saved to: %s as: %s.png\n", SaveFilePath.c_str(), Filename.c_str());
+		std::string BlockPath = path + "/" + Data.at("Name").get<std::string>();
+		nlohmann::json OwnData = Data;
+		OwnData.erase("Blocks");
+		blockData[BlockPath].push_back(OwnData);
 
-		Canvas->ClearData();
+		if (Data.contains("Blocks"))
+		{
+			CollectBlockData(Data.at("Blocks"), BlockPath, blockData);
+		}
+	}
+}
+
+void Layout::FindStaticBlocks(const std::shared_ptr<BaseBlock>& block, const std::string& path, const std::map<std::string, nlohmann::json>& blockData,
+							  const std::set<std::string>& varyingBlocks, bool& bVaryingDrawn, std::set<std::string>& staticBlocks)
+{
+	//The blocks are visited in the order they are drawn. A block can only be static when the block and every block linked to it are the same in every image,
+	//since their positions depend on it, and when nothing that changes has been drawn before it that it could be covering.
+	//A block with the name of a PotentialLayout isn't used when its data is added so it can't be static either
+	for (const std::shared_ptr<BaseBlock>& LinkedBlock : block->GetLinkedBlocks())
+	{
+		std::string BlockPath = path + "/" + LinkedBlock->GetName();
+		bool bVarying = false;
+		for (const std::string& VaryingBlock : varyingBlocks)
+		{
+			if (VaryingBlock == BlockPath || VaryingBlock.rfind(BlockPath + "/", 0) == 0)
+			{
+				bVarying = true;
+				break;
+			}
+		}
+
+		if (!bVarying && !bVaryingDrawn && FindLayout(block->GetPotentialLayouts(), LinkedBlock->GetName()).empty())
+		{
+			staticBlocks.insert(BlockPath);
+			continue;
+		}
+
+		if (blockData.find(BlockPath) != blockData.end() || varyingBlocks.find(BlockPath) != varyingBlocks.end())
+		{
+			bVaryingDrawn = true;
+		}
+		FindStaticBlocks(LinkedBlock, BlockPath, blockData, varyingBlocks, bVaryingDrawn, staticBlocks);
+	}
+
+	//Data for a block that isn't linked to this one makes a block from a PotentialLayout which is drawn after the linked blocks
+	for (const std::pair<const std::string, nlohmann::json>& Data : blockData)
+	{
+		if (Data.first.rfind(path + "/", 0) == 0 && Data.first.find('/', path.size() + 1) == std::string::npos &&
+			FindBlock(block->GetLinkedBlocks(), Data.first.substr(path.size() + 1)) == nullptr)
+		{
+			bVaryingDrawn = true;
+		}
+	}
+	for (const std::string& VaryingBlock : varyingBlocks)
+	{
+		if (VaryingBlock.rfind(path + "/", 0) == 0 && VaryingBlock.find('/', path.size() + 1) == std::string::npos &&
+			FindBlock(block->GetLinkedBlocks(), VaryingBlock.substr(path.size() + 1)) == nullptr)
+		{
+			bVaryingDrawn = true;
+		}
+	}
+}
+
+void Layout::MarkStaticBlocks(const std::shared_ptr<BaseBlock>& block, const std::string& path, const bool& bParentStatic)
+{
+	for (const std::shared_ptr<BaseBlock>& LinkedBlock : block->GetLinkedBlocks())
+	{
+		std::string BlockPath = path + "/" + LinkedBlock->GetName();
+		bool bStatic = bParentStatic || StaticBlocks.find(BlockPath) != StaticBlocks.end();
+		LinkedBlock->SetStatic(bStatic);
+		MarkStaticBlocks(LinkedBlock, BlockPath, bStatic);
 	}
 }
 
@@ -99,43 +729,115 @@ void Layout::SetFont(const std::shared_ptr<Font>& font)
 	TextFont = font;
 }
 
-void Layout::SaveImage(const std::string& saveLocation)
+std::shared_ptr<Image> Layout::ComposeImage(const std::shared_ptr<BaseBlock>& canvas)
 {
+	//Resolve the positions of all the blocks in one go, after that we just have to go through the plan to draw them and calculate the LowestHeight.
+	std::vector<RenderItem> RenderPlan;
+	canvas->CompileRenderPlan(RenderPlan, TextFont);
+
+	int LowestHeight = StaticLowestHeight;
+	for (const RenderItem& Item : RenderPlan)
+	{
+		if (Item.BottomHeight > LowestHeight)
+		{
+			LowestHeight = Item.BottomHeight;
+		}
+	}
+
 	//We don't want to alter the stored BackgroundImage so we will copy the data add the rest from this layout onto it and save that instead.
 	std::shared_ptr<Image> Background(new Image());
+
+	//Without the crop nothing has to happen to the background after the blocks are drawn so they go straight onto it.
+	//The StaticBackground already has the static blocks drawn onto it
+	bool bCrop = BottomDistanceFromLowestLayoutBlock > 0 && BottomHeight > 0 && LowestHeight + BottomDistanceFromLowestLayoutBlock < BackgroundImage->GetHeight();
+	if (!bCrop)
+	{
+		Background->CopyValue(StaticBackground != nullptr ? StaticBackground : BackgroundImage);
+		for (const RenderItem& Item : RenderPlan)
+		{
+			if (Item.bDraw)
+			{
+				Item.Block->DrawData(Background, Item.WidthOffset, Item.HeightOffset);
+			}
+		}
+		return Background;
+	}
+
 	Background->CopyValue(BackgroundImage);
 
-	//Because the Background image might have to be altered before saving we will add everything to an empty canvas and add that to the background.
-	std::shared_ptr<Image> EmptyCanvas(new Image(Background->GetWidth(), Background->GetHeight()));
-	
-	//Go through all the blocks and add them to the canvas and calculate the LowestHeight.
-	int LowestHeight = 0;
-	Canvas->SaveImage(EmptyCanvas, TextFont);
-	FindLowestHeight(Canvas, LowestHeight);
+	//Because the Background image has to be altered before the blocks are added we will draw them onto a canvas and add that to the background.
+	//The canvas only covers the area the blocks are drawn in, which includes the static blocks that are copied from the StaticLayer
+	int Left = StaticLeft;
+	int Top = StaticTop;
+	int Right = StaticRight;
+	int Bottom = StaticBottom;
+	for (const RenderItem& Item : RenderPlan)
+	{
+		AddToBounds(Item, Background->GetWidth(), Background->GetHeight(), Left, Top, Right, Bottom);
+	}
 
-	//Due to what I want to do with this project I want to be able to crop the background to more accurately fit the contents of the layout.
-	//Because of this I am cutting out a section of the background and moving it up a little to fit better.
-	if (BottomDistanceFromLowestLayoutBlock > 0 && BottomHeight > 0 && LowestHeight + BottomDistanceFromLowestLayoutBlock < Background->GetHeight())
+	std::shared_ptr<Image> BlockCanvas;
+	if (Right > Left && Bottom > Top)
 	{
-		std::shared_ptr<Image> BottomSection = Background->CopyImageSection(Background->GetWidth(), BottomHeight, 0, Background->GetHeight() - BottomHeight);
-		if (LowestHeight < Background->GetHeight() - BottomHeight) 
+		if (StaticLayer != nullptr)
 		{
-			Background->EraseImageSection(Background->GetWidth(), Background->GetHeight() - LowestHeight, 0, LowestHeight);
+			BlockCanvas = StaticLayer->CopyImageSection(Right - Left, Bottom - Top, Left, Top);
 		}
-		else 
+		else
+		{
+			BlockCanvas = std::shared_ptr<Image>(new Image(Right - Left, Bottom - Top, ImageFormat));
+		}
+
+		for (const RenderItem& Item : RenderPlan)
 		{
-			Background->EraseImageSection(Background->GetWidth(), Background->GetHeight() - BottomHeight, 0, Background->GetHeight() - BottomHeight);
+			if (Item.bDraw)
+			{
+				Item.Block->DrawData(BlockCanvas, Item.WidthOffset - Left, Item.HeightOffset - Top);
+			}
 		}
-		Background->CompositeImage(BottomSection, 0, LowestHeight + BottomDistanceFromLowestLayoutBlock - BottomHeight);
 	}
 
-	Background->CompositeImage(EmptyCanvas);
-	Background->SaveImage(saveLocation);
+	//Due to what I want to do with this project I want to be able to crop the background to more accurately fit the contents of the layout.
+	//Because of this I am cutting out a section of the background and moving it up a little to fit better.
+	std::shared_ptr<Image> BottomSection = Background->CopyImageSection(Background->GetWidth(), BottomHeight, 0, Background->GetHeight() - BottomHeight);
+	if (LowestHeight < Background->GetHeight() - BottomHeight) 
+	{
+		Background->EraseImageSection(Background->GetWidth(), Background->GetHeight() - LowestHeight, 0, LowestHeight);
+	}
+	else 
+	{
+		Background->EraseImageSection(Background->GetWidth(), Background->GetHeight() - BottomHeight, 0, Background->GetHeight() - BottomHeight);
+	}
+	Background->CompositeImage(BottomSection, 0, LowestHeight + BottomDistanceFromLowestLayoutBlock - BottomHeight);
+
+	if (BlockCanvas != nullptr)
+	{
+		Background->CompositeImage(BlockCanvas, Left, Top);
+	}
+	return Background;
+}
+
+void Layout::AddToBounds(const RenderItem& item, const int& width, const int& height, int& left, int& top, int& right, int& bottom)
+{
+	//Only the part of the block that is on the image counts, a block that is completely off of it doesn't change the bounds
+	int ItemLeft = std::max(item.WidthOffset, 0);
+	int ItemTop = std::max(item.HeightOffset, 0);
+	int ItemRight = std::min(item.WidthOffset + item.Width, width);
+	int ItemBottom = std::min(item.HeightOffset + item.Height, height);
+	if (!item.bDraw || ItemRight <= ItemLeft || ItemBottom <= ItemTop)
+	{
+		return;
+	}
+
+	left = std::min(left, ItemLeft);
+	top = std::min(top, ItemTop);
+	right = std::max(right, ItemRight);
+	bottom = std::max(bottom, ItemBottom);
 }
 
 void Layout::SetBackgroundImage(const std::string& filename) 
 {
-	std::shared_ptr<Image> TempImage(new Image(filename));
+	std::shared_ptr<Image> TempImage(new Image(filename, ImageFormat));
 	if (TempImage.get() != nullptr)
 	{
 		SetBackgroundImage(TempImage);
@@ -149,9 +851,13 @@ void Layout::SetBackgroundImage(const std::string& filename)
 void Layout::SetBackgroundImage(const std::shared_ptr<Image>& image)
 {
 	BackgroundImage = image;
+
+	//The StaticBackground was made from the old background so the static blocks are drawn again for the next batch
+	StaticBackground = nullptr;
+	StaticBlockData = nlohmann::json();
 }
 
-void Layout::AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& previousBlock)
+void Layout::AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& previousBlock)
 {
 	//Add a block and all it's data, because a block can be multiple types we have to make sure we create the correct one which is the first thing we do
 	std::string Type = JData.at("Type");
@@ -186,7 +892,7 @@ void Layout::AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlo
 		TempBlock->SetPreviousBlock(previousBlock);
 		if (previousBlock == nullptr)
 		{
-			Canvas->AddBlock(TempBlock);
+			canvas->AddBlock(TempBlock);
 		}
 		else
 		{
@@ -201,7 +907,7 @@ void Layout::AddBlock(const nlohmann::json& JData, const std::shared_ptr<BaseBlo
 		nlohmann::json Block = JData.at("Blocks");
 		for (int i = 0; i < Block.size(); i++)
 		{
-			AddBlock(Block[i], TempBlock);
+			AddBlock(Block[i], canvas, TempBlock);
 		}
 	}
 }
@@ -261,7 +967,7 @@ void Layout::AddBaseBlockData(const nlohmann::json& JData, const std::shared_ptr
 	}
 }
 
-void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& previousBlock)
+void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& previousBlock)
 {
 	//If no name is given we won't be able to find this block to add data to so the function will return right there.
 	std::string TempName = "";
@@ -279,11 +985,11 @@ void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBloc
 	std::shared_ptr<BaseBlock> TempBlock = nullptr;
 	if (previousBlock == nullptr) 
 	{
-		FindBlock(TempBlock, Canvas, TempName);
+		FindBlock(TempBlock, canvas, canvas, TempName);
 	}
 	else 
 	{
-		FindBlock(TempBlock, previousBlock, TempName);
+		FindBlock(TempBlock, canvas, previousBlock, TempName);
 	}
 
 	if (TempBlock == nullptr) 
@@ -299,13 +1005,19 @@ void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBloc
 		return;
 	}
 
+	//A static block already has its data drawn into the StaticLayer and the same goes for the blocks linked to it
+	if (TempBlock->IsStatic())
+	{
+		return;
+	}
+
 	//Depending on the BlockType we want to add different data into it
 	if (TempBlock->GetBlockType() == BlockType::TypeImage)
 	{
 		std::shared_ptr<ImageBlock> TempImageBlock = std::dynamic_pointer_cast<ImageBlock>(TempBlock);
 		if (JData.contains("StoredImage"))
 		{
-			TempImageBlock->SetStoredImage(std::shared_ptr<Image>(new Image{ JData.at("StoredImage") }));
+			TempImageBlock->SetStoredImage(AssetCache::GetImage(JData.at("StoredImage"), ImageFormat, bTrimImages));
 		}
 		else 
 		{
@@ -357,12 +1069,10 @@ void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBloc
 		{
 			TempPixel->a = JData.at("ColorA");
 		}
-		if(TextFont != nullptr) 
-		{
-			TempTextBlock->SetCalculatedWidth(TextFont->GetStringLength(TempTextBlock->GetText(), TempTextBlock->GetPixelHeight()));
-		}
 
+		//The width is measured when the text is rendered in PrepareData
 		TempTextBlock->SetColor(TempPixel);
+		TempTextBlock->SetPixelFormat(ImageFormat);
 	}
 
 	//For a specific image in a group we might want to change the paramaters so they can be overwritten here
@@ -377,17 +1087,17 @@ void Layout::AddData(const nlohmann::json& JData, const std::shared_ptr<BaseBloc
 		nlohmann::json Data = JData.at("Blocks");
 		for (int i = 0; i < Data.size(); i++)
 		{
-			AddData(Data[i], TempBlock);
+			AddData(Data[i], canvas, TempBlock);
 		}
 	}
 }
 
-void Layout::FindBlock(std::shared_ptr<BaseBlock>& foundBlock, const std::shared_ptr<BaseBlock>& currentBlock, const std::string& name)
+void Layout::FindBlock(std::shared_ptr<BaseBlock>& foundBlock, const std::shared_ptr<BaseBlock>& canvas, const std::shared_ptr<BaseBlock>& currentBlock, const std::string& name)
 {
 	//If the name is the same as a PotentialLayout from the previousBlock it will be constructed.
 	if (!FindLayout(currentBlock->GetPotentialLayouts(), name).empty())
 	{
-		AddBlock(FindLayout(currentBlock->GetPotentialLayouts(), name), currentBlock);
+		AddBlock(FindLayout(currentBlock->GetPotentialLayouts(), name), canvas, currentBlock);
 		foundBlock = currentBlock->GetLinkedBlocks()[currentBlock->GetLinkedBlocks().size() - 1];
 		foundBlock->SetCreatedThroughPossibleLayout(true);
 	}
@@ -430,17 +1140,3 @@ nlohmann::json Layout::FindLayout(const std::vector<std::shared_ptr<PotentialLay
 
 	return nullptr;
 }
-
-//Recursively go througj every block until we have gone through all of them and found the lowest one
-void Layout::FindLowestHeight(const std::shared_ptr<BaseBlock>& currentBlock, int& lowestValue)
-{
-	if (currentBlock->CalculateBottomHeight() > lowestValue)
-	{
-		lowestValue = currentBlock->CalculateBottomHeight();
-	}
-
-	for (std::shared_ptr<BaseBlock> NextBlock : currentBlock->GetLinkedBlocks())
-	{
-		FindLowestHeight(NextBlock, lowestValue);
-	}
-}
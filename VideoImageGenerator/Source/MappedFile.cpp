@@ -0,0 +1,113 @@
+#include "../Header/MappedFile.h"
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	//An empty file can't be mapped so it goes through ReadFile as well, which gives an open file without any data
+#if defined(_WIN32)
+	HANDLE File = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (File != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER FileSize;
+		if (GetFileSizeEx(File, &FileSize) && FileSize.QuadPart > 0)
+		{
+			HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (Mapping != NULL)
+			{
+				MappedData = static_cast<const unsigned char*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+				if (MappedData != nullptr)
+				{
+					Size = static_cast<size_t>(FileSize.QuadPart);
+					FileHandle = File;
+					MappingHandle = Mapping;
+					bMapped = true;
+				}
+				else
+				{
+					CloseHandle(Mapping);
+				}
+			}
+		}
+
+		if (!bMapped)
+		{
+			CloseHandle(File);
+		}
+	}
+#else
+	int Descriptor = open(filename.c_str(), O_RDONLY);
+	if (Descriptor >= 0)
+	{
+		//The mapping keeps the file alive on its own so the descriptor can be closed right away
+		struct stat Status;
+		if (fstat(Descriptor, &Status) == 0 && S_ISREG(Status.st_mode) && Status.st_size > 0)
+		{
+			void* Data = mmap(nullptr, static_cast<size_t>(Status.st_size), PROT_READ, MAP_PRIVATE, Descriptor, 0);
+			if (Data != MAP_FAILED)
+			{
+				MappedData = static_cast<const unsigned char*>(Data);
+				Size = static_cast<size_t>(Status.st_size);
+				bMapped = true;
+			}
+		}
+		close(Descriptor);
+	}
+#endif
+
+	bOpen = bMapped || ReadFile(filename);
+}
+
+MappedFile::~MappedFile()
+{
+	if (!bMapped)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	UnmapViewOfFile(MappedData);
+	CloseHandle(MappingHandle);
+	CloseHandle(FileHandle);
+#else
+	munmap(const_cast<unsigned char*>(MappedData), Size);
+#endif
+}
+
+bool MappedFile::ReadFile(const std::string& filename)
+{
+	//fopen_s only exists on Windows
+	FILE* File = nullptr;
+#if defined(_WIN32)
+	fopen_s(&File, filename.c_str(), "rb");
+#else
+	File = fopen(filename.c_str(), "rb");
+#endif
+	if (File == nullptr)
+	{
+		return false;
+	}
+
+	//The size isn't always known up front so the file is read in pieces until it ends
+	unsigned char Piece[65536];
+	size_t PieceSize = 0;
+	while ((PieceSize = fread(Piece, 1, sizeof(Piece), File)) > 0)
+	{
+		Buffer.insert(Buffer.end(), Piece, Piece + PieceSize);
+	}
+
+	bool bRead = ferror(File) == 0;
+	fclose(File);
+	Size = Buffer.size();
+	return bRead;
+}
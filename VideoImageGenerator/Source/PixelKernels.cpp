@@ -0,0 +1,500 @@
+#include "../Header/PixelKernels.h"
+#include <algorithm>
+
+//The vectorized kernels only exist on x86, every other platform will use the scalar kernels
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXELKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET_SSE41
+#define KERNEL_TARGET_AVX2
+#else
+//GCC and Clang only allow intrinsics in functions that are compiled for that instruction set
+#define KERNEL_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+KernelInstructionSet PixelKernels::SupportedInstructionSet = PixelKernels::DetectInstructionSet();
+KernelInstructionSet PixelKernels::ActiveInstructionSet = PixelKernels::SupportedInstructionSet;
+
+//Divide a product of 2 unsigned chars by 255 with rounding without doing the division
+static inline int DivideBy255(const int& value)
+{
+	return (value + 128 + ((value + 128) >> 8)) >> 8;
+}
+
+static void CompositeRowScalar(Pixel* row, const Pixel* otherRow, const int& count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		//A premultiplied pixel without alpha has no color either so it wouldn't change anything
+		if (otherRow[i].a > 0.0f)
+		{
+			row[i].Composite(otherRow[i]);
+		}
+	}
+}
+
+static void CompositePackedRowScalar(unsigned char* row, const unsigned char* otherRow, const int& count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned char* OtherPixel = otherRow + i * 4;
+		unsigned char* CurrentPixel = row + i * 4;
+
+		//Same as Pixel::Composite but with every channel scaled by 255 so we can stay in integers
+		int InverseAlpha = 255 - OtherPixel[3];
+		if (InverseAlpha == 0)
+		{
+			memcpy(CurrentPixel, OtherPixel, 4);
+		}
+		else if (InverseAlpha < 255)
+		{
+			for (int channel = 0; channel < 4; channel++)
+			{
+				CurrentPixel[channel] = std::min(255, OtherPixel[channel] + DivideBy255(CurrentPixel[channel] * InverseAlpha));
+			}
+		}
+	}
+}
+
+static void CompositeCoverageRowScalar(Pixel* row, const unsigned char* coverageRow, const int& count, const Pixel& color)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (coverageRow[i] > 0)
+		{
+			//Build the premultiplied pixel the same way UnsignedCharToImageData does for text
+			float Alpha = coverageRow[i] / 255.0f * color.a;
+			row[i].Composite(Pixel{ color.r * Alpha, color.g * Alpha, color.b * Alpha, Alpha });
+		}
+	}
+}
+
+static void CompositePackedCoverageRowScalar(unsigned char* row, const unsigned char* coverageRow, const int& count, const Pixel& color)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (coverageRow[i] > 0)
+		{
+			//Build the pixel in floats and round it the way ConvertFormat does, so the text is the same as a Float text image converted to RGBA8
+			float Alpha = coverageRow[i] / 255.0f * color.a;
+			unsigned char OtherPixel[4] = { static_cast<unsigned char>(static_cast<int>(color.r * Alpha * 255.0f + 0.5f)), static_cast<unsigned char>(static_cast<int>(color.g * Alpha * 255.0f + 0.5f)),
+											static_cast<unsigned char>(static_cast<int>(color.b * Alpha * 255.0f + 0.5f)), static_cast<unsigned char>(static_cast<int>(Alpha * 255.0f + 0.5f)) };
+			CompositePackedRowScalar(row + i * 4, OtherPixel, 1);
+		}
+	}
+}
+
+//The BT.601 limited range coefficients scaled by 256, the chroma has 128 added to it after the shift
+static inline int LumaFromRGB(const int& r, const int& g, const int& b)
+{
+	return ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+}
+
+static inline int ChromaUFromRGB(const int& r, const int& g, const int& b)
+{
+	return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+static inline int ChromaVFromRGB(const int& r, const int& g, const int& b)
+{
+	return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static void ConvertLumaRowScalar(const unsigned char* row, const int& count, unsigned char* lumaRow)
+{
+	for (int i = 0; i < count; i++)
+	{
+		lumaRow[i] = static_cast<unsigned char>(LumaFromRGB(row[i * 4], row[i * 4 + 1], row[i * 4 + 2]));
+	}
+}
+
+static void ConvertChromaRowScalar(const unsigned char* row, const unsigned char* nextRow, const int& count, unsigned char* uRow, unsigned char* vRow)
+{
+	for (int i = 0; i * 2 < count; i++)
+	{
+		int Left = i * 8;
+		int Right = i * 2 + 1 < count ? Left + 4 : Left;
+		int Average[3];
+		for (int channel = 0; channel < 3; channel++)
+		{
+			Average[channel] = (row[Left + channel] + row[Right + channel] + nextRow[Left + channel] + nextRow[Right + channel] + 2) >> 2;
+		}
+		uRow[i] = static_cast<unsigned char>(ChromaUFromRGB(Average[0], Average[1], Average[2]));
+		vRow[i] = static_cast<unsigned char>(ChromaVFromRGB(Average[0], Average[1], Average[2]));
+	}
+}
+
+#ifdef PIXELKERNELS_X86
+KERNEL_TARGET_SSE41 static void CompositeRowSSE41(Pixel* row, const Pixel* otherRow, const int& count)
+{
+	const __m128 One = _mm_set1_ps(1.0f);
+	for (int i = 0; i < count; i++)
+	{
+		__m128 Current = _mm_loadu_ps(&row[i].r);
+		__m128 Other = _mm_loadu_ps(&otherRow[i].r);
+		__m128 InverseAlpha = _mm_sub_ps(One, _mm_shuffle_ps(Other, Other, _MM_SHUFFLE(3, 3, 3, 3)));
+		_mm_storeu_ps(&row[i].r, _mm_add_ps(Other, _mm_mul_ps(InverseAlpha, Current)));
+	}
+}
+
+//Blends the 8 channels of 2 pixels which have been widened to 16 bits, this is DivideBy255 done on every lane
+KERNEL_TARGET_SSE41 static inline __m128i BlendChannels(const __m128i& current, const __m128i& inverseAlpha)
+{
+	__m128i Product = _mm_add_epi16(_mm_mullo_epi16(current, inverseAlpha), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(Product, _mm_srli_epi16(Product, 8)), 8);
+}
+
+KERNEL_TARGET_SSE41 static void CompositePackedRowSSE41(unsigned char* row, const unsigned char* otherRow, const int& count)
+{
+	//Copies the alpha of every pixel into all 4 of its channels
+	const __m128i AlphaShuffle = _mm_set_epi8(15, 15, 15, 15, 11, 11, 11, 11, 7, 7, 7, 7, 3, 3, 3, 3);
+	const __m128i Zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i Current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i * 4));
+		__m128i Other = _mm_loadu_si128(reinterpret_cast<const __m128i*>(otherRow + i * 4));
+		__m128i InverseAlpha = _mm_sub_epi8(_mm_set1_epi8(-1), _mm_shuffle_epi8(Other, AlphaShuffle));
+
+		__m128i Low = BlendChannels(_mm_unpacklo_epi8(Current, Zero), _mm_unpacklo_epi8(InverseAlpha, Zero));
+		__m128i High = BlendChannels(_mm_unpackhi_epi8(Current, Zero), _mm_unpackhi_epi8(InverseAlpha, Zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i * 4), _mm_adds_epu8(Other, _mm_packus_epi16(Low, High)));
+	}
+
+	//The last pixels that don't fill a register are done by the scalar kernel
+	CompositePackedRowScalar(row + i * 4, otherRow + i * 4, count - i);
+}
+
+KERNEL_TARGET_SSE41 static void CompositeCoverageRowSSE41(Pixel* row, const unsigned char* coverageRow, const int& count, const Pixel& color)
+{
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Color = _mm_set_ps(1.0f, color.b, color.g, color.r);
+	const __m128 ColorAlpha = _mm_set1_ps(color.a);
+	for (int i = 0; i < count; i++)
+	{
+		if (coverageRow[i] == 0)
+		{
+			continue;
+		}
+
+		//Same order of operations as the scalar kernel so the results match exactly
+		__m128 Alpha = _mm_mul_ps(_mm_set1_ps(coverageRow[i] / 255.0f), ColorAlpha);
+		__m128 Other = _mm_mul_ps(Color, Alpha);
+		__m128 Current = _mm_loadu_ps(&row[i].r);
+		_mm_storeu_ps(&row[i].r, _mm_add_ps(Other, _mm_mul_ps(_mm_sub_ps(One, Alpha), Current)));
+	}
+}
+
+//Widens 4 pixels to 16 bits and multiplies them with the coefficients of a channel, the sums of every pixel end up next to each other as 32 bits
+KERNEL_TARGET_SSE41 static inline __m128i MultiplyPixels(const __m128i& low, const __m128i& high, const __m128i& coefficients)
+{
+	return _mm_hadd_epi32(_mm_madd_epi16(low, coefficients), _mm_madd_epi16(high, coefficients));
+}
+
+KERNEL_TARGET_SSE41 static void ConvertLumaRowSSE41(const unsigned char* row, const int& count, unsigned char* lumaRow)
+{
+	const __m128i Coefficients = _mm_set_epi16(0, 25, 129, 66, 0, 25, 129, 66);
+	const __m128i Round = _mm_set1_epi32(128);
+	const __m128i Offset = _mm_set1_epi32(16);
+	const __m128i Zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i First = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i * 4));
+		__m128i Second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i * 4 + 16));
+		__m128i FirstLuma = MultiplyPixels(_mm_unpacklo_epi8(First, Zero), _mm_unpackhi_epi8(First, Zero), Coefficients);
+		__m128i SecondLuma = MultiplyPixels(_mm_unpacklo_epi8(Second, Zero), _mm_unpackhi_epi8(Second, Zero), Coefficients);
+		FirstLuma = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(FirstLuma, Round), 8), Offset);
+		SecondLuma = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(SecondLuma, Round), 8), Offset);
+		__m128i Packed = _mm_packs_epi32(FirstLuma, SecondLuma);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(lumaRow + i), _mm_packus_epi16(Packed, Packed));
+	}
+
+	ConvertLumaRowScalar(row + i * 4, count - i, lumaRow + i);
+}
+
+//Adds the 2 rows of 4 pixels together and then the pixels next to each other, which leaves the sums of 2 blocks of 2x2 pixels
+KERNEL_TARGET_SSE41 static inline __m128i AverageBlocks(const unsigned char* row, const unsigned char* nextRow)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	__m128i Top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+	__m128i Bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nextRow));
+	__m128i Low = _mm_add_epi16(_mm_unpacklo_epi8(Top, Zero), _mm_unpacklo_epi8(Bottom, Zero));
+	__m128i High = _mm_add_epi16(_mm_unpackhi_epi8(Top, Zero), _mm_unpackhi_epi8(Bottom, Zero));
+	__m128i Sum = _mm_add_epi16(_mm_unpacklo_epi64(Low, High), _mm_unpackhi_epi64(Low, High));
+	return _mm_srli_epi16(_mm_add_epi16(Sum, _mm_set1_epi16(2)), 2);
+}
+
+KERNEL_TARGET_SSE41 static void ConvertChromaRowSSE41(const unsigned char* row, const unsigned char* nextRow, const int& count, unsigned char* uRow, unsigned char* vRow)
+{
+	const __m128i CoefficientsU = _mm_set_epi16(0, 112, -74, -38, 0, 112, -74, -38);
+	const __m128i CoefficientsV = _mm_set_epi16(0, -18, -94, 112, 0, -18, -94, 112);
+	const __m128i Round = _mm_set1_epi32(128);
+	int i = 0;
+	for (; i * 2 + 8 <= count; i += 4)
+	{
+		__m128i First = AverageBlocks(row + i * 8, nextRow + i * 8);
+		__m128i Second = AverageBlocks(row + i * 8 + 16, nextRow + i * 8 + 16);
+		__m128i ChromaU = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(MultiplyPixels(First, Second, CoefficientsU), Round), 8), Round);
+		__m128i ChromaV = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(MultiplyPixels(First, Second, CoefficientsV), Round), 8), Round);
+
+		//The 4 U samples end up in the first 4 bytes and the 4 V samples in the 4 after that
+		__m128i Packed = _mm_packs_epi32(ChromaU, ChromaV);
+		Packed = _mm_packus_epi16(Packed, Packed);
+		int PackedU = _mm_cvtsi128_si32(Packed);
+		int PackedV = _mm_extract_epi32(Packed, 1);
+		memcpy(uRow + i, &PackedU, 4);
+		memcpy(vRow + i, &PackedV, 4);
+	}
+
+	ConvertChromaRowScalar(row + i * 8, nextRow + i * 8, count - i * 2, uRow + i, vRow + i);
+}
+
+//The AVX2 kernels blend 2 Float pixels or 8 RGBA8 pixels at a time
+KERNEL_TARGET_AVX2 static void CompositeRowAVX2(Pixel* row, const Pixel* otherRow, const int& count)
+{
+	const __m256 One = _mm256_set1_ps(1.0f);
+	int i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		__m256 Current = _mm256_loadu_ps(&row[i].r);
+		__m256 Other = _mm256_loadu_ps(&otherRow[i].r);
+		__m256 InverseAlpha = _mm256_sub_ps(One, _mm256_permute_ps(Other, _MM_SHUFFLE(3, 3, 3, 3)));
+		_mm256_storeu_ps(&row[i].r, _mm256_add_ps(Other, _mm256_mul_ps(InverseAlpha, Current)));
+	}
+
+	//An odd amount of pixels leaves 1 pixel which doesn't fill the register
+	CompositeRowSSE41(row + i, otherRow + i, count - i);
+}
+
+KERNEL_TARGET_AVX2 static inline __m256i BlendChannelsAVX2(const __m256i& current, const __m256i& inverseAlpha)
+{
+	__m256i Product = _mm256_add_epi16(_mm256_mullo_epi16(current, inverseAlpha), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(Product, _mm256_srli_epi16(Product, 8)), 8);
+}
+
+KERNEL_TARGET_AVX2 static void CompositePackedRowAVX2(unsigned char* row, const unsigned char* otherRow, const int& count)
+{
+	const __m256i AlphaShuffle = _mm256_set_epi8(15, 15, 15, 15, 11, 11, 11, 11, 7, 7, 7, 7, 3, 3, 3, 3, 15, 15, 15, 15, 11, 11, 11, 11, 7, 7, 7, 7, 3, 3, 3, 3);
+	const __m256i Zero = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i Current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i * 4));
+		__m256i Other = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(otherRow + i * 4));
+		__m256i InverseAlpha = _mm256_sub_epi8(_mm256_set1_epi8(-1), _mm256_shuffle_epi8(Other, AlphaShuffle));
+
+		//Unpacking and packing both stay within the 128 bit lanes so the pixels end up back in the same order
+		__m256i Low = BlendChannelsAVX2(_mm256_unpacklo_epi8(Current, Zero), _mm256_unpacklo_epi8(InverseAlpha, Zero));
+		__m256i High = BlendChannelsAVX2(_mm256_unpackhi_epi8(Current, Zero), _mm256_unpackhi_epi8(InverseAlpha, Zero));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i * 4), _mm256_adds_epu8(Other, _mm256_packus_epi16(Low, High)));
+	}
+
+	CompositePackedRowSSE41(row + i * 4, otherRow + i * 4, count - i);
+}
+KERNEL_TARGET_AVX2 static void ConvertLumaRowAVX2(const unsigned char* row, const int& count, unsigned char* lumaRow)
+{
+	const __m256i Coefficients = _mm256_set_epi16(0, 25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66);
+	const __m256i Round = _mm256_set1_epi32(128);
+	const __m256i Offset = _mm256_set1_epi32(16);
+	const __m256i Zero = _mm256_setzero_si256();
+
+	//Everything stays within the 128 bit lanes so the 16 lumas come out as 4 groups of 4 which are put back in order at the end
+	const __m256i Order = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i First = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i * 4));
+		__m256i Second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i * 4 + 32));
+		__m256i FirstLuma = _mm256_hadd_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(First, Zero), Coefficients), _mm256_madd_epi16(_mm256_unpackhi_epi8(First, Zero), Coefficients));
+		__m256i SecondLuma = _mm256_hadd_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(Second, Zero), Coefficients), _mm256_madd_epi16(_mm256_unpackhi_epi8(Second, Zero), Coefficients));
+		FirstLuma = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(FirstLuma, Round), 8), Offset);
+		SecondLuma = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(SecondLuma, Round), 8), Offset);
+		__m256i Packed = _mm256_packs_epi32(FirstLuma, SecondLuma);
+		Packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(Packed, Packed), Order);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lumaRow + i), _mm256_castsi256_si128(Packed));
+	}
+
+	ConvertLumaRowSSE41(row + i * 4, count - i, lumaRow + i);
+}
+
+//The AVX2 version of AverageBlocks, the 4 sums end up as 2 blocks in every 128 bit lane
+KERNEL_TARGET_AVX2 static inline __m256i AverageBlocksAVX2(const unsigned char* row, const unsigned char* nextRow)
+{
+	const __m256i Zero = _mm256_setzero_si256();
+	__m256i Top = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+	__m256i Bottom = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nextRow));
+	__m256i Low = _mm256_add_epi16(_mm256_unpacklo_epi8(Top, Zero), _mm256_unpacklo_epi8(Bottom, Zero));
+	__m256i High = _mm256_add_epi16(_mm256_unpackhi_epi8(Top, Zero), _mm256_unpackhi_epi8(Bottom, Zero));
+	__m256i Sum = _mm256_add_epi16(_mm256_unpacklo_epi64(Low, High), _mm256_unpackhi_epi64(Low, High));
+	return _mm256_srli_epi16(_mm256_add_epi16(Sum, _mm256_set1_epi16(2)), 2);
+}
+
+KERNEL_TARGET_AVX2 static void ConvertChromaRowAVX2(const unsigned char* row, const unsigned char* nextRow, const int& count, unsigned char* uRow, unsigned char* vRow)
+{
+	const __m256i CoefficientsU = _mm256_set_epi16(0, 112, -74, -38, 0, 112, -74, -38, 0, 112, -74, -38, 0, 112, -74, -38);
+	const __m256i CoefficientsV = _mm256_set_epi16(0, -18, -94, 112, 0, -18, -94, 112, 0, -18, -94, 112, 0, -18, -94, 112);
+	const __m256i Round = _mm256_set1_epi32(128);
+
+	//The horizontal add stays within the lanes so the blocks come out as 0, 1, 4, 5, 2, 3, 6, 7 and are put in order before packing,
+	//after packing the U samples are in the first 4 bytes of every lane and the V samples in the 4 after that
+	const __m256i BlockOrder = _mm256_set_epi32(7, 6, 3, 2, 5, 4, 1, 0);
+	const __m256i PackedOrder = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+	int i = 0;
+	for (; i * 2 + 16 <= count; i += 8)
+	{
+		__m256i First = AverageBlocksAVX2(row + i * 8, nextRow + i * 8);
+		__m256i Second = AverageBlocksAVX2(row + i * 8 + 32, nextRow + i * 8 + 32);
+		__m256i ChromaU = _mm256_hadd_epi32(_mm256_madd_epi16(First, CoefficientsU), _mm256_madd_epi16(Second, CoefficientsU));
+		__m256i ChromaV = _mm256_hadd_epi32(_mm256_madd_epi16(First, CoefficientsV), _mm256_madd_epi16(Second, CoefficientsV));
+		ChromaU = _mm256_permutevar8x32_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(ChromaU, Round), 8), Round), BlockOrder);
+		ChromaV = _mm256_permutevar8x32_epi32(_mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(ChromaV, Round), 8), Round), BlockOrder);
+
+		__m256i Packed = _mm256_packs_epi32(ChromaU, ChromaV);
+		Packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(Packed, Packed), PackedOrder);
+		__m128i Samples = _mm256_castsi256_si128(Packed);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(uRow + i), Samples);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(vRow + i), _mm_unpackhi_epi64(Samples, Samples));
+	}
+
+	ConvertChromaRowSSE41(row + i * 8, nextRow + i * 8, count - i * 2, uRow + i, vRow + i);
+}
+#endif
+
+void PixelKernels::CompositeRow(Pixel* row, const Pixel* otherRow, const int& count)
+{
+#ifdef PIXELKERNELS_X86
+	switch (ActiveInstructionSet)
+	{
+	case KernelInstructionSet::KernelAVX2:
+		CompositeRowAVX2(row, otherRow, count);
+		return;
+	case KernelInstructionSet::KernelSSE41:
+		CompositeRowSSE41(row, otherRow, count);
+		return;
+	default:
+		break;
+	}
+#endif
+	CompositeRowScalar(row, otherRow, count);
+}
+
+void PixelKernels::CompositePackedRow(unsigned char* row, const unsigned char* otherRow, const int& count)
+{
+#ifdef PIXELKERNELS_X86
+	switch (ActiveInstructionSet)
+	{
+	case KernelInstructionSet::KernelAVX2:
+		CompositePackedRowAVX2(row, otherRow, count);
+		return;
+	case KernelInstructionSet::KernelSSE41:
+		CompositePackedRowSSE41(row, otherRow, count);
+		return;
+	default:
+		break;
+	}
+#endif
+	CompositePackedRowScalar(row, otherRow, count);
+}
+
+void PixelKernels::CompositeCoverageRow(Pixel* row, const unsigned char* coverageRow, const int& count, const Pixel& color)
+{
+#ifdef PIXELKERNELS_X86
+	//A glyph row is too short for AVX2 to be worth it so both use the SSE4.1 kernel
+	if (ActiveInstructionSet >= KernelInstructionSet::KernelSSE41)
+	{
+		CompositeCoverageRowSSE41(row, coverageRow, count, color);
+		return;
+	}
+#endif
+	CompositeCoverageRowScalar(row, coverageRow, count, color);
+}
+
+void PixelKernels::CompositePackedCoverageRow(unsigned char* row, const unsigned char* coverageRow, const int& count, const Pixel& color)
+{
+	CompositePackedCoverageRowScalar(row, coverageRow, count, color);
+}
+
+void PixelKernels::ConvertLumaRow(const unsigned char* row, const int& count, unsigned char* lumaRow)
+{
+#ifdef PIXELKERNELS_X86
+	switch (ActiveInstructionSet)
+	{
+	case KernelInstructionSet::KernelAVX2:
+		ConvertLumaRowAVX2(row, count, lumaRow);
+		return;
+	case KernelInstructionSet::KernelSSE41:
+		ConvertLumaRowSSE41(row, count, lumaRow);
+		return;
+	default:
+		break;
+	}
+#endif
+	ConvertLumaRowScalar(row, count, lumaRow);
+}
+
+void PixelKernels::ConvertChromaRow(const unsigned char* row, const unsigned char* nextRow, const int& count, unsigned char* uRow, unsigned char* vRow)
+{
+#ifdef PIXELKERNELS_X86
+	switch (ActiveInstructionSet)
+	{
+	case KernelInstructionSet::KernelAVX2:
+		ConvertChromaRowAVX2(row, nextRow, count, uRow, vRow);
+		return;
+	case KernelInstructionSet::KernelSSE41:
+		ConvertChromaRowSSE41(row, nextRow, count, uRow, vRow);
+		return;
+	default:
+		break;
+	}
+#endif
+	ConvertChromaRowScalar(row, nextRow, count, uRow, vRow);
+}
+
+void PixelKernels::SetInstructionSet(const KernelInstructionSet& instructionSet)
+{
+	ActiveInstructionSet = instructionSet > SupportedInstructionSet ? SupportedInstructionSet : instructionSet;
+}
+
+KernelInstructionSet PixelKernels::GetInstructionSet()
+{
+	return ActiveInstructionSet;
+}
+
+KernelInstructionSet PixelKernels::DetectInstructionSet()
+{
+#ifdef PIXELKERNELS_X86
+#if defined(_MSC_VER)
+	//Leaf 1 tells us about SSE4.1 and whether the OS saves the AVX registers, leaf 7 tells us about AVX2
+	int CpuInfo[4];
+	__cpuid(CpuInfo, 0);
+	int HighestLeaf = CpuInfo[0];
+	__cpuid(CpuInfo, 1);
+	bool bSSE41 = (CpuInfo[2] & (1 << 19)) != 0;
+	bool bAVX = (CpuInfo[2] & (1 << 27)) != 0 && (CpuInfo[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	bool bAVX2 = false;
+	if (bAVX && HighestLeaf >= 7)
+	{
+		__cpuidex(CpuInfo, 7, 0);
+		bAVX2 = (CpuInfo[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	bool bSSE41 = __builtin_cpu_supports("sse4.1");
+	bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+	if (bAVX2)
+	{
+		return KernelInstructionSet::KernelAVX2;
+	}
+	if (bSSE41)
+	{
+		return KernelInstructionSet::KernelSSE41;
+	}
+#endif
+	return KernelInstructionSet::KernelScalar;
+}
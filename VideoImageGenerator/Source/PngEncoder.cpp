@@ -0,0 +1,927 @@
+#include "../Header/PngEncoder.h"
+#include "../Header/BoundedQueue.h"
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+std::atomic<int> PngEncoder::CompressionLevel = 3;
+std::atomic<int> PngEncoder::Threads = 0;
+
+//The amount of filtered bytes a thread deflates at a time, matches can reach back WindowSize bytes which is the most deflate allows
+static const size_t ChunkSize = 256 * 1024;
+static const size_t WindowSize = 32768;
+static const int RowsPerJob = 64;
+static const int MinimumMatch = 3;
+static const int MaximumMatch = 258;
+static const int HashBits = 15;
+
+//A block gets its own huffman codes so they are written once this many symbols have been gathered to follow the changes in the image
+static const int BlockSymbols = 16384;
+
+static const int LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const int CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+//How hard the match finder tries for every level, a longer chain finds better matches and lazy matching checks if a match starting a byte later is longer
+struct DeflateLevel
+{
+	int MaxChain;
+	int NiceLength;
+	bool bLazy;
+};
+static const DeflateLevel Levels[10] = { {0, 0, false}, {4, 16, false}, {8, 32, false}, {16, 64, false}, {16, 64, true},
+										 {32, 128, true}, {64, 128, true}, {128, 258, true}, {512, 258, true}, {2048, 258, true} };
+
+//Writes the bits of the deflate stream starting at the lowest bit of every byte
+struct BitWriter
+{
+	std::vector<unsigned char>& Out;
+	unsigned long long Buffer = 0;
+	int Count = 0;
+
+	BitWriter(std::vector<unsigned char>& out) : Out(out) {}
+
+	void Put(const unsigned int& bits, const int& count)
+	{
+		Buffer |= static_cast<unsigned long long>(bits) << Count;
+		Count += count;
+		while (Count >= 8)
+		{
+			Out.push_back(static_cast<unsigned char>(Buffer & 0xFF));
+			Buffer >>= 8;
+			Count -= 8;
+		}
+	}
+
+	void Align()
+	{
+		if (Count > 0)
+		{
+			Out.push_back(static_cast<unsigned char>(Buffer & 0xFF));
+			Buffer = 0;
+			Count = 0;
+		}
+	}
+};
+
+//The threads that help encode the images, they are started the first time they are needed and kept for every image after that.
+//All the images that are encoded at the same time share them, the thread encoding an image works on its own jobs as well
+//so it never has to wait for a helper to be free
+class EncodeThreadPool
+{
+public:
+	~EncodeThreadPool()
+	{
+		Tasks.Close();
+		for (std::thread& Worker : Workers)
+		{
+			Worker.join();
+		}
+	}
+
+	void Run(const std::function<void()>& task, const int& helpers)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(WorkersMutex);
+			while (static_cast<int>(Workers.size()) < helpers)
+			{
+				Workers.push_back(std::thread([this]()
+					{
+						std::function<void()> Task;
+						while (Tasks.Pop(Task))
+						{
+							Task();
+						}
+					}));
+			}
+		}
+
+		for (int i = 0; i < helpers; i++)
+		{
+			Tasks.Push(task);
+		}
+	}
+
+private:
+	BoundedQueue<std::function<void()>> Tasks{ 1024 };
+	std::vector<std::thread> Workers;
+	std::mutex WorkersMutex;
+};
+
+//The jobs of a single ParallelFor, a helper can start after all the jobs are done so it keeps this alive on its own
+struct ParallelJobs
+{
+	const std::function<void(const int&)>* Job = nullptr;
+	int JobCount = 0;
+	std::atomic<int> NextJob = 0;
+	std::atomic<int> FinishedJobs = 0;
+	std::mutex FinishedMutex;
+	std::condition_variable Finished;
+};
+
+//Runs the jobs on up to threadCount threads, the calling thread takes jobs as well and a single thread runs them all itself
+static void ParallelFor(const int& jobCount, const int& threadCount, const std::function<void(const int&)>& job)
+{
+	int Helpers = std::min(threadCount, jobCount) - 1;
+	if (Helpers <= 0)
+	{
+		for (int i = 0; i < jobCount; i++)
+		{
+			job(i);
+		}
+		return;
+	}
+
+	std::shared_ptr<ParallelJobs> Jobs(new ParallelJobs());
+	Jobs->Job = &job;
+	Jobs->JobCount = jobCount;
+	auto Worker = [Jobs]()
+	{
+		for (int i = Jobs->NextJob++; i < Jobs->JobCount; i = Jobs->NextJob++)
+		{
+			(*Jobs->Job)(i);
+			if (++Jobs->FinishedJobs == Jobs->JobCount)
+			{
+				std::lock_guard<std::mutex> Lock(Jobs->FinishedMutex);
+				Jobs->Finished.notify_all();
+			}
+		}
+	};
+
+	static EncodeThreadPool Pool;
+	Pool.Run(Worker, Helpers);
+	Worker();
+
+	std::unique_lock<std::mutex> Lock(Jobs->FinishedMutex);
+	Jobs->Finished.wait(Lock, [&Jobs]() { return Jobs->FinishedJobs == Jobs->JobCount; });
+}
+
+//Huffman codes are read starting at their highest bit so they are reversed once here and can be written like any other bits
+static unsigned short ReverseBits(unsigned int code, const int& length)
+{
+	unsigned int Reversed = 0;
+	for (int i = 0; i < length; i++)
+	{
+		Reversed = (Reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	return static_cast<unsigned short>(Reversed);
+}
+
+static void MakeCanonicalCodes(const unsigned char* lengths, const int& count, unsigned short* codes)
+{
+	int LengthCount[16] = {};
+	for (int i = 0; i < count; i++)
+	{
+		LengthCount[lengths[i]]++;
+	}
+	LengthCount[0] = 0;
+
+	int NextCode[16] = {};
+	int Code = 0;
+	for (int Bits = 1; Bits < 16; Bits++)
+	{
+		Code = (Code + LengthCount[Bits - 1]) << 1;
+		NextCode[Bits] = Code;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		codes[i] = lengths[i] == 0 ? 0 : ReverseBits(NextCode[lengths[i]]++, lengths[i]);
+	}
+}
+
+//Builds the huffman code lengths for the frequencies, when a code gets longer than the maximum the frequencies are halved until it fits.
+//At least 2 symbols always get a code so the tree is complete
+static void MakeCodeLengths(const unsigned int* frequencies, const int& count, const int& maxLength, unsigned char* lengths)
+{
+	std::vector<unsigned long long> Frequencies(frequencies, frequencies + count);
+	int UsedSymbols = 0;
+	for (int i = 0; i < count; i++)
+	{
+		UsedSymbols += Frequencies[i] > 0 ? 1 : 0;
+	}
+
+	for (int i = 0; i < count && UsedSymbols < 2; i++)
+	{
+		if (Frequencies[i] == 0)
+		{
+			Frequencies[i] = 1;
+			UsedSymbols++;
+		}
+	}
+
+	while (true)
+	{
+		std::memset(lengths, 0, count);
+		std::vector<int> Parent(count * 2, -1);
+		std::priority_queue<std::pair<unsigned long long, int>, std::vector<std::pair<unsigned long long, int>>, std::greater<std::pair<unsigned long long, int>>> Nodes;
+		for (int i = 0; i < count; i++)
+		{
+			if (Frequencies[i] > 0)
+			{
+				Nodes.push({ Frequencies[i], i });
+			}
+		}
+
+		int NextNode = count;
+		while (Nodes.size() > 1)
+		{
+			std::pair<unsigned long long, int> First = Nodes.top();
+			Nodes.pop();
+			std::pair<unsigned long long, int> Second = Nodes.top();
+			Nodes.pop();
+			Parent[First.second] = NextNode;
+			Parent[Second.second] = NextNode;
+			Nodes.push({ First.first + Second.first, NextNode++ });
+		}
+
+		int Longest = 0;
+		for (int i = 0; i < count; i++)
+		{
+			if (Frequencies[i] > 0)
+			{
+				int Depth = 0;
+				for (int Node = i; Parent[Node] != -1; Node = Parent[Node])
+				{
+					Depth++;
+				}
+				lengths[i] = static_cast<unsigned char>(Depth);
+				Longest = std::max(Longest, Depth);
+			}
+		}
+
+		if (Longest <= maxLength)
+		{
+			return;
+		}
+
+		for (unsigned long long& Frequency : Frequencies)
+		{
+			Frequency = Frequency > 0 ? (Frequency + 1) / 2 : 0;
+		}
+	}
+}
+
+static int FindDistanceCode(const int& distance)
+{
+	return static_cast<int>(std::upper_bound(DistanceBase, DistanceBase + 30, distance) - DistanceBase) - 1;
+}
+
+static int FindLengthCode(const int& length)
+{
+	return static_cast<int>(std::upper_bound(LengthBase, LengthBase + 29, length) - LengthBase) - 1;
+}
+
+//Turns the code lengths into the runs the dynamic block header is written with, the symbol is in the low 5 bits and the repeat count above it
+static void RunLengthEncode(const unsigned char* lengths, const int& count, std::vector<unsigned short>& runs)
+{
+	int i = 0;
+	while (i < count)
+	{
+		int Length = lengths[i];
+		int Run = 1;
+		while (i + Run < count && lengths[i + Run] == Length)
+		{
+			Run++;
+		}
+		i += Run;
+
+		if (Length == 0)
+		{
+			while (Run >= 11)
+			{
+				int Repeat = std::min(Run, 138);
+				runs.push_back(static_cast<unsigned short>(18 | ((Repeat - 11) << 5)));
+				Run -= Repeat;
+			}
+			if (Run >= 3)
+			{
+				runs.push_back(static_cast<unsigned short>(17 | ((Run - 3) << 5)));
+				Run = 0;
+			}
+		}
+		else
+		{
+			runs.push_back(static_cast<unsigned short>(Length));
+			Run--;
+			while (Run >= 3)
+			{
+				int Repeat = std::min(Run, 6);
+				runs.push_back(static_cast<unsigned short>(16 | ((Repeat - 3) << 5)));
+				Run -= Repeat;
+			}
+		}
+
+		for (; Run > 0; Run--)
+		{
+			runs.push_back(static_cast<unsigned short>(Length));
+		}
+	}
+}
+
+//Writes the data without compressing it, this is split into blocks of at most 65535 bytes which always end on a byte boundary
+static void WriteStoredBlocks(BitWriter& writer, const unsigned char* data, const size_t& length, const bool& bFinal)
+{
+	for (size_t Position = 0; Position < length; Position += 65535)
+	{
+		unsigned int Length = static_cast<unsigned int>(std::min<size_t>(65535, length - Position));
+		writer.Put(bFinal && Position + Length == length ? 1 : 0, 1);
+		writer.Put(0, 2);
+		writer.Align();
+		writer.Put(Length, 16);
+		writer.Put(~Length & 0xFFFF, 16);
+		writer.Out.insert(writer.Out.end(), data + Position, data + Position + Length);
+	}
+}
+
+//Writes the symbols with the fixed codes, codes made for this block or stored as they are, whichever is smallest.
+//A symbol is a literal when the distance in the upper bits is 0, otherwise the low 9 bits are the length of the match.
+//The symbols cover the length bytes of the data
+static void WriteBlock(BitWriter& writer, const std::vector<unsigned int>& symbols, const unsigned char* data, const size_t& length, const bool& bFinal)
+{
+	unsigned int LiteralFrequencies[286] = {};
+	unsigned int DistanceFrequencies[30] = {};
+	for (unsigned int Symbol : symbols)
+	{
+		int Distance = Symbol >> 9;
+		if (Distance == 0)
+		{
+			LiteralFrequencies[Symbol]++;
+		}
+		else
+		{
+			LiteralFrequencies[257 + FindLengthCode(Symbol & 511)]++;
+			DistanceFrequencies[FindDistanceCode(Distance)]++;
+		}
+	}
+	LiteralFrequencies[256] = 1;
+
+	unsigned char FixedLiteralLengths[288];
+	unsigned char FixedDistanceLengths[30];
+	for (int i = 0; i < 288; i++)
+	{
+		FixedLiteralLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+	std::memset(FixedDistanceLengths, 5, sizeof(FixedDistanceLengths));
+
+	unsigned char LiteralLengths[288] = {};
+	unsigned char DistanceLengths[30] = {};
+	MakeCodeLengths(LiteralFrequencies, 286, 15, LiteralLengths);
+	MakeCodeLengths(DistanceFrequencies, 30, 15, DistanceLengths);
+
+	int LiteralCount = 286;
+	while (LiteralCount > 257 && LiteralLengths[LiteralCount - 1] == 0)
+	{
+		LiteralCount--;
+	}
+	int DistanceCount = 30;
+	while (DistanceCount > 1 && DistanceLengths[DistanceCount - 1] == 0)
+	{
+		DistanceCount--;
+	}
+
+	//The code lengths of both alphabets are written as one list with their own huffman code
+	std::vector<unsigned char> AllLengths(LiteralLengths, LiteralLengths + LiteralCount);
+	AllLengths.insert(AllLengths.end(), DistanceLengths, DistanceLengths + DistanceCount);
+	std::vector<unsigned short> Runs;
+	RunLengthEncode(AllLengths.data(), static_cast<int>(AllLengths.size()), Runs);
+
+	unsigned int CodeLengthFrequencies[19] = {};
+	for (unsigned short Run : Runs)
+	{
+		CodeLengthFrequencies[Run & 31]++;
+	}
+	unsigned char CodeLengthLengths[19] = {};
+	MakeCodeLengths(CodeLengthFrequencies, 19, 7, CodeLengthLengths);
+
+	int CodeLengthCount = 19;
+	while (CodeLengthCount > 4 && CodeLengthLengths[CodeLengthOrder[CodeLengthCount - 1]] == 0)
+	{
+		CodeLengthCount--;
+	}
+
+	unsigned long long DynamicBits = 14 + 3 * CodeLengthCount;
+	for (unsigned short Run : Runs)
+	{
+		int Symbol = Run & 31;
+		DynamicBits += CodeLengthLengths[Symbol] + (Symbol == 16 ? 2 : Symbol == 17 ? 3 : Symbol == 18 ? 7 : 0);
+	}
+	unsigned long long FixedBits = 0;
+	for (int i = 0; i < 286; i++)
+	{
+		DynamicBits += static_cast<unsigned long long>(LiteralFrequencies[i]) * LiteralLengths[i];
+		FixedBits += static_cast<unsigned long long>(LiteralFrequencies[i]) * FixedLiteralLengths[i];
+	}
+	for (int i = 0; i < 30; i++)
+	{
+		DynamicBits += static_cast<unsigned long long>(DistanceFrequencies[i]) * DistanceLengths[i];
+		FixedBits += static_cast<unsigned long long>(DistanceFrequencies[i]) * FixedDistanceLengths[i];
+	}
+
+	unsigned long long ExtraBits = 0;
+	for (int i = 0; i < 29; i++)
+	{
+		ExtraBits += static_cast<unsigned long long>(LiteralFrequencies[257 + i]) * LengthExtra[i];
+	}
+	for (int i = 0; i < 30; i++)
+	{
+		ExtraBits += static_cast<unsigned long long>(DistanceFrequencies[i]) * DistanceExtra[i];
+	}
+
+	//Data that doesn't compress like noise is smaller when it is stored, every stored block has 5 bytes of header
+	unsigned long long StoredBits = (length + 5 * ((length + 65534) / 65535)) * 8;
+	if (length > 0 && StoredBits < std::min(DynamicBits, FixedBits) + ExtraBits)
+	{
+		WriteStoredBlocks(writer, data, length, bFinal);
+		return;
+	}
+
+	bool bDynamic = DynamicBits < FixedBits;
+	const unsigned char* UsedLiteralLengths = bDynamic ? LiteralLengths : FixedLiteralLengths;
+	const unsigned char* UsedDistanceLengths = bDynamic ? DistanceLengths : FixedDistanceLengths;
+	unsigned short LiteralCodes[288];
+	unsigned short DistanceCodes[30];
+	MakeCanonicalCodes(UsedLiteralLengths, 288, LiteralCodes);
+	MakeCanonicalCodes(UsedDistanceLengths, 30, DistanceCodes);
+
+	writer.Put(bFinal ? 1 : 0, 1);
+	writer.Put(bDynamic ? 2 : 1, 2);
+	if (bDynamic)
+	{
+		unsigned short CodeLengthCodes[19];
+		MakeCanonicalCodes(CodeLengthLengths, 19, CodeLengthCodes);
+
+		writer.Put(LiteralCount - 257, 5);
+		writer.Put(DistanceCount - 1, 5);
+		writer.Put(CodeLengthCount - 4, 4);
+		for (int i = 0; i < CodeLengthCount; i++)
+		{
+			writer.Put(CodeLengthLengths[CodeLengthOrder[i]], 3);
+		}
+
+		for (unsigned short Run : Runs)
+		{
+			int Symbol = Run & 31;
+			writer.Put(CodeLengthCodes[Symbol], CodeLengthLengths[Symbol]);
+			if (Symbol >= 16)
+			{
+				writer.Put(Run >> 5, Symbol == 16 ? 2 : Symbol == 17 ? 3 : 7);
+			}
+		}
+	}
+
+	for (unsigned int Symbol : symbols)
+	{
+		int Distance = Symbol >> 9;
+		if (Distance == 0)
+		{
+			writer.Put(LiteralCodes[Symbol], UsedLiteralLengths[Symbol]);
+			continue;
+		}
+
+		int Length = Symbol & 511;
+		int LengthCode = FindLengthCode(Length);
+		writer.Put(LiteralCodes[257 + LengthCode], UsedLiteralLengths[257 + LengthCode]);
+		writer.Put(Length - LengthBase[LengthCode], LengthExtra[LengthCode]);
+
+		int DistanceCode = FindDistanceCode(Distance);
+		writer.Put(DistanceCodes[DistanceCode], UsedDistanceLengths[DistanceCode]);
+		writer.Put(Distance - DistanceBase[DistanceCode], DistanceExtra[DistanceCode]);
+	}
+	writer.Put(LiteralCodes[256], UsedLiteralLengths[256]);
+}
+
+void PngEncoder::SetCompressionLevel(const int& level)
+{
+	CompressionLevel = std::clamp(level, 0, 9);
+}
+
+void PngEncoder::SetThreads(const int& threads)
+{
+	Threads = std::max(0, threads);
+}
+
+unsigned int PngEncoder::Adler32(const unsigned char* data, const size_t& length, unsigned int adler)
+{
+	//5552 is the most bytes that can be added before the sums have to be reduced to not overflow
+	unsigned int First = adler & 0xFFFF;
+	unsigned int Second = adler >> 16;
+	size_t Position = 0;
+	while (Position < length)
+	{
+		size_t End = std::min(length, Position + 5552);
+		for (; Position < End; Position++)
+		{
+			First += data[Position];
+			Second += First;
+		}
+		First %= 65521;
+		Second %= 65521;
+	}
+	return (Second << 16) | First;
+}
+
+unsigned int PngEncoder::CombineAdler32(const unsigned int& firstAdler, const unsigned int& secondAdler, const size_t& secondLength)
+{
+	const unsigned long long Base = 65521;
+	unsigned long long Remainder = secondLength % Base;
+	unsigned long long First = firstAdler & 0xFFFF;
+	unsigned long long Second = (Remainder * First) % Base;
+	First += (secondAdler & 0xFFFF) + Base - 1;
+	Second += (firstAdler >> 16) + (secondAdler >> 16) + Base - Remainder;
+	First %= Base;
+	Second %= Base;
+	return static_cast<unsigned int>((Second << 16) | First);
+}
+
+unsigned int PngEncoder::Crc32(const unsigned char* data, const size_t& length, unsigned int crc)
+{
+	//The tables let 8 bytes be done at once, table k gives the crc of a byte followed by k zero bytes
+	static const std::vector<std::vector<unsigned int>> Tables = []()
+	{
+		std::vector<std::vector<unsigned int>> NewTables(8, std::vector<unsigned int>(256));
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int Value = i;
+			for (int Bit = 0; Bit < 8; Bit++)
+			{
+				Value = (Value & 1) ? 0xEDB88320u ^ (Value >> 1) : Value >> 1;
+			}
+			NewTables[0][i] = Value;
+		}
+
+		for (int Table = 1; Table < 8; Table++)
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				NewTables[Table][i] = (NewTables[Table - 1][i] >> 8) ^ NewTables[0][NewTables[Table - 1][i] & 0xFF];
+			}
+		}
+		return NewTables;
+	}();
+
+	crc = ~crc;
+	size_t Position = 0;
+	for (; Position + 8 <= length; Position += 8)
+	{
+		const unsigned char* Bytes = data + Position;
+		unsigned int First = crc ^ (Bytes[0] | Bytes[1] << 8 | Bytes[2] << 16 | static_cast<unsigned int>(Bytes[3]) << 24);
+		unsigned int Second = Bytes[4] | Bytes[5] << 8 | Bytes[6] << 16 | static_cast<unsigned int>(Bytes[7]) << 24;
+		crc = Tables[7][First & 0xFF] ^ Tables[6][(First >> 8) & 0xFF] ^ Tables[5][(First >> 16) & 0xFF] ^ Tables[4][First >> 24] ^
+			  Tables[3][Second & 0xFF] ^ Tables[2][(Second >> 8) & 0xFF] ^ Tables[1][(Second >> 16) & 0xFF] ^ Tables[0][Second >> 24];
+	}
+
+	for (; Position < length; Position++)
+	{
+		crc = Tables[0][(crc ^ data[Position]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+void PngEncoder::FilterRow(const unsigned char* row, const unsigned char* previousRow, const int& rowBytes, const int& components, unsigned char* filteredRow, unsigned char* scratch)
+{
+	//Every filter is tried and the one with the lowest sum of the bytes as signed values is kept, the same guess stb_image_write makes.
+	//The first pixel has no left neighbour so it is done on its own which keeps the loops over the rest simple enough to vectorize
+	//The sizes are copied since writing the bytes could change a referenced value as far as the compiler knows, which stops it from vectorizing
+	int RowBytes = rowBytes;
+	int Components = components;
+	int BestFilter = 0;
+	long long BestEstimate = LLONG_MAX;
+	for (int Filter = 0; Filter < 5; Filter++)
+	{
+		unsigned char* Candidate = scratch + static_cast<size_t>(Filter) * RowBytes;
+		switch (Filter)
+		{
+		case 0:
+			std::memcpy(Candidate, row, RowBytes);
+			break;
+		case 1:
+			std::memcpy(Candidate, row, Components);
+			for (int i = Components; i < RowBytes; i++)
+			{
+				Candidate[i] = static_cast<unsigned char>(row[i] - row[i - Components]);
+			}
+			break;
+		case 2:
+			for (int i = 0; i < RowBytes; i++)
+			{
+				Candidate[i] = static_cast<unsigned char>(row[i] - previousRow[i]);
+			}
+			break;
+		case 3:
+			for (int i = 0; i < Components; i++)
+			{
+				Candidate[i] = static_cast<unsigned char>(row[i] - (previousRow[i] >> 1));
+			}
+			for (int i = Components; i < RowBytes; i++)
+			{
+				Candidate[i] = static_cast<unsigned char>(row[i] - ((row[i - Components] + previousRow[i]) >> 1));
+			}
+			break;
+		case 4:
+			//Without a left neighbour the paeth predictor always picks the byte above
+			for (int i = 0; i < Components; i++)
+			{
+				Candidate[i] = static_cast<unsigned char>(row[i] - previousRow[i]);
+			}
+			for (int i = Components; i < RowBytes; i++)
+			{
+				int Left = row[i - Components];
+				int Up = previousRow[i];
+				int UpLeft = previousRow[i - Components];
+				int LeftDistance = abs(Up - UpLeft);
+				int UpDistance = abs(Left - UpLeft);
+				int UpLeftDistance = abs(Left + Up - 2 * UpLeft);
+				int Prediction = UpDistance <= UpLeftDistance ? Up : UpLeft;
+				Prediction = LeftDistance <= UpDistance && LeftDistance <= UpLeftDistance ? Left : Prediction;
+				Candidate[i] = static_cast<unsigned char>(row[i] - Prediction);
+			}
+			break;
+		}
+
+		long long Estimate = 0;
+		for (int i = 0; i < RowBytes; i++)
+		{
+			Estimate += abs(static_cast<signed char>(Candidate[i]));
+		}
+
+		if (Estimate < BestEstimate)
+		{
+			BestEstimate = Estimate;
+			BestFilter = Filter;
+		}
+	}
+
+	filteredRow[0] = static_cast<unsigned char>(BestFilter);
+	std::memcpy(filteredRow + 1, scratch + static_cast<size_t>(BestFilter) * RowBytes, RowBytes);
+}
+
+void PngEncoder::DeflateChunk(const unsigned char* data, const size_t& dictionaryStart, const size_t& start, const size_t& end, const int& level, const bool& bLast, std::vector<unsigned char>& out)
+{
+	BitWriter Writer(out);
+	DeflateLevel Level = Levels[level];
+
+	//Without compression the data is only split into stored blocks
+	if (Level.MaxChain == 0)
+	{
+		WriteStoredBlocks(Writer, data + start, end - start, bLast);
+		return;
+	}
+
+	//The chains hold the earlier positions with the same hash, the positions are stored from the start of the dictionary
+	std::vector<int> Head(static_cast<size_t>(1) << HashBits, -1);
+	std::vector<int> Previous(end - dictionaryStart, -1);
+	auto Insert = [&](const size_t& position)
+	{
+		if (position + MinimumMatch <= end)
+		{
+			unsigned int Hash = ((static_cast<unsigned int>(data[position]) << 16 | data[position + 1] << 8 | data[position + 2]) * 2654435761u) >> (32 - HashBits);
+			Previous[position - dictionaryStart] = Head[Hash];
+			Head[Hash] = static_cast<int>(position - dictionaryStart);
+		}
+	};
+
+	auto FindMatch = [&](const size_t& position, int& bestLength, int& bestDistance)
+	{
+		bestLength = 0;
+		bestDistance = 0;
+		int Limit = static_cast<int>(std::min<size_t>(MaximumMatch, end - position));
+		if (Limit < MinimumMatch)
+		{
+			return;
+		}
+
+		unsigned int Hash = ((static_cast<unsigned int>(data[position]) << 16 | data[position + 1] << 8 | data[position + 2]) * 2654435761u) >> (32 - HashBits);
+		int Chain = Level.MaxChain;
+		for (int Candidate = Head[Hash]; Candidate >= 0 && Chain > 0; Candidate = Previous[Candidate], Chain--)
+		{
+			size_t CandidatePosition = dictionaryStart + Candidate;
+			if (position - CandidatePosition > WindowSize)
+			{
+				break;
+			}
+
+			const unsigned char* Current = data + position;
+			const unsigned char* Earlier = data + CandidatePosition;
+			if (Earlier[bestLength] != Current[bestLength])
+			{
+				continue;
+			}
+
+			int Length = 0;
+			while (Length < Limit && Current[Length] == Earlier[Length])
+			{
+				Length++;
+			}
+
+			if (Length > bestLength)
+			{
+				bestLength = Length;
+				bestDistance = static_cast<int>(position - CandidatePosition);
+				if (Length >= Level.NiceLength || Length == Limit)
+				{
+					break;
+				}
+			}
+		}
+
+		//A short match that is far away costs more bits than the literals it replaces
+		if (bestLength < MinimumMatch || (bestLength == MinimumMatch && bestDistance > 4096))
+		{
+			bestLength = 0;
+		}
+	};
+
+	for (size_t Position = dictionaryStart; Position < start; Position++)
+	{
+		Insert(Position);
+	}
+
+	std::vector<unsigned int> Symbols;
+	Symbols.reserve(BlockSymbols);
+	size_t BlockStart = start;
+	size_t Position = start;
+	while (Position < end)
+	{
+		int Length = 0;
+		int Distance = 0;
+		FindMatch(Position, Length, Distance);
+		Insert(Position);
+
+		//When the match starting at the next byte is longer this byte is written as a literal instead
+		if (Length > 0 && Level.bLazy && Length < Level.NiceLength && Position + 1 < end)
+		{
+			int NextLength = 0;
+			int NextDistance = 0;
+			FindMatch(Position + 1, NextLength, NextDistance);
+			if (NextLength > Length)
+			{
+				Length = 0;
+			}
+		}
+
+		if (Length > 0)
+		{
+			Symbols.push_back(static_cast<unsigned int>(Distance << 9 | Length));
+			for (int i = 1; i < Length; i++)
+			{
+				Insert(Position + i);
+			}
+			Position += Length;
+		}
+		else
+		{
+			Symbols.push_back(data[Position]);
+			Position++;
+		}
+
+		if (Symbols.size() >= BlockSymbols)
+		{
+			WriteBlock(Writer, Symbols, data + BlockStart, Position - BlockStart, false);
+			Symbols.clear();
+			BlockStart = Position;
+		}
+	}
+	WriteBlock(Writer, Symbols, data + BlockStart, Position - BlockStart, bLast);
+
+	//An empty stored block brings a chunk that isn't the last one to a byte boundary so the next chunk can be added right after it
+	if (!bLast)
+	{
+		Writer.Put(0, 3);
+		Writer.Align();
+		Writer.Put(0, 16);
+		Writer.Put(0xFFFF, 16);
+	}
+	Writer.Align();
+}
+
+std::vector<unsigned char> PngEncoder::Encode(const unsigned char* data, const int& width, const int& height, const int& components, const int& level, const int& threads)
+{
+	if (data == nullptr || width < 1 || height < 1 || components < 1 || components > 4)
+	{
+		return std::vector<unsigned char>();
+	}
+
+	//The defaults are read once so another thread changing them can't give a mix of both
+	int Level = level >= 0 ? std::min(level, 9) : CompressionLevel.load();
+	int ThreadCount = threads >= 0 ? threads : Threads.load();
+	if (ThreadCount == 0)
+	{
+		ThreadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	int RowBytes = width * components;
+	size_t FilteredRowBytes = static_cast<size_t>(RowBytes) + 1;
+	size_t FilteredSize = FilteredRowBytes * height;
+	std::vector<unsigned char> Filtered(FilteredSize);
+
+	//The filters only look at the rows themselves so the rows can be filtered in any order, without compression they aren't filtered at all
+	std::vector<unsigned char> EmptyRow(RowBytes, 0);
+	ParallelFor((height + RowsPerJob - 1) / RowsPerJob, ThreadCount, [&](const int& job)
+		{
+			std::vector<unsigned char> Scratch(static_cast<size_t>(RowBytes) * 5);
+			for (int y = job * RowsPerJob; y < std::min(height, (job + 1) * RowsPerJob); y++)
+			{
+				const unsigned char* Row = data + static_cast<size_t>(y) * RowBytes;
+				unsigned char* FilteredRow = Filtered.data() + y * FilteredRowBytes;
+				if (Level == 0)
+				{
+					FilteredRow[0] = 0;
+					std::memcpy(FilteredRow + 1, Row, RowBytes);
+				}
+				else
+				{
+					FilterRow(Row, y == 0 ? EmptyRow.data() : Row - RowBytes, RowBytes, components, FilteredRow, Scratch.data());
+				}
+			}
+		});
+
+	int ChunkCount = static_cast<int>((FilteredSize + ChunkSize - 1) / ChunkSize);
+	std::vector<std::vector<unsigned char>> Chunks(ChunkCount);
+	std::vector<unsigned int> ChunkAdlers(ChunkCount);
+	ParallelFor(ChunkCount, ThreadCount, [&](const int& job)
+		{
+			size_t Start = job * ChunkSize;
+			size_t End = std::min(FilteredSize, Start + ChunkSize);
+			DeflateChunk(Filtered.data(), Start > WindowSize ? Start - WindowSize : 0, Start, End, Level, job == ChunkCount - 1, Chunks[job]);
+			ChunkAdlers[job] = Adler32(Filtered.data() + Start, End - Start);
+		});
+
+	//The zlib header says which kind of compression was used, the second byte is picked so the header is a multiple of 31
+	std::vector<unsigned char> Zlib = { 0x78, static_cast<unsigned char>(Level < 2 ? 0x01 : Level < 6 ? 0x5E : Level == 6 ? 0x9C : 0xDA) };
+	unsigned int Adler = 1;
+	for (int i = 0; i < ChunkCount; i++)
+	{
+		Zlib.insert(Zlib.end(), Chunks[i].begin(), Chunks[i].end());
+		size_t Start = i * ChunkSize;
+		Adler = CombineAdler32(Adler, ChunkAdlers[i], std::min(FilteredSize, Start + ChunkSize) - Start);
+	}
+	for (int Shift = 24; Shift >= 0; Shift -= 8)
+	{
+		Zlib.push_back(static_cast<unsigned char>(Adler >> Shift));
+	}
+
+	std::vector<unsigned char> Png = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	auto AddUnsignedInt = [&Png](const unsigned int& value)
+	{
+		for (int Shift = 24; Shift >= 0; Shift -= 8)
+		{
+			Png.push_back(static_cast<unsigned char>(value >> Shift));
+		}
+	};
+	auto AddChunk = [&](const char* type, const unsigned char* chunkData, const size_t& length)
+	{
+		AddUnsignedInt(static_cast<unsigned int>(length));
+		Png.insert(Png.end(), type, type + 4);
+		Png.insert(Png.end(), chunkData, chunkData + length);
+		AddUnsignedInt(Crc32(chunkData, length, Crc32(reinterpret_cast<const unsigned char*>(type), 4)));
+	};
+
+	//The color type follows the components: grey, grey and alpha, rgb and rgba
+	const unsigned char ColorTypes[5] = { 0, 0, 4, 2, 6 };
+	unsigned char Header[13] = { static_cast<unsigned char>(width >> 24), static_cast<unsigned char>(width >> 16), static_cast<unsigned char>(width >> 8), static_cast<unsigned char>(width),
+								 static_cast<unsigned char>(height >> 24), static_cast<unsigned char>(height >> 16), static_cast<unsigned char>(height >> 8), static_cast<unsigned char>(height),
+								 8, ColorTypes[components], 0, 0, 0 };
+	AddChunk("IHDR", Header, sizeof(Header));
+	AddChunk("IDAT", Zlib.data(), Zlib.size());
+	AddChunk("IEND", nullptr, 0);
+	return Png;
+}
+
+bool PngEncoder::WriteFile(const std::string& filename, const unsigned char* data, const int& width, const int& height, const int& components, size_t* bytesWritten,
+	const int& level, const int& threads)
+{
+	std::vector<unsigned char> Png = Encode(data, width, height, components, level, threads);
+	if (Png.empty())
+	{
+		return false;
+	}
+
+	std::ofstream File(filename, std::ios::binary);
+	if (!File.is_open())
+	{
+		return false;
+	}
+
+	File.write(reinterpret_cast<const char*>(Png.data()), Png.size());
+	if (!File.good())
+	{
+		return false;
+	}
+
+	if (bytesWritten != nullptr)
+	{
+		*bytesWritten = Png.size();
+	}
+	return true;
+}
@@ -0,0 +1,267 @@
+#include "../Header/Profiler.h"
+#include <algorithm>
+#include <fstream>
+
+bool Profiler::bEnabled = false;
+std::chrono::steady_clock::time_point Profiler::RunStart = std::chrono::steady_clock::now();
+std::mutex Profiler::ProfilerMutex;
+ProfilerStats Profiler::RunStats;
+FrameSpread Profiler::FrameTotals;
+std::vector<FrameReport> Profiler::Frames;
+
+//The frame that is being rendered on this thread
+static thread_local FrameReport CurrentFrame;
+static thread_local bool bInFrame = false;
+
+void ProfilerStats::Add(const ProfilerStats& other)
+{
+	for (int i = 0; i < ProfilerStage::StageCount; i++)
+	{
+		StageNanoseconds[i] += other.StageNanoseconds[i];
+		StageCalls[i] += other.StageCalls[i];
+	}
+
+	for (int i = 0; i < ProfilerCounter::CounterCount; i++)
+	{
+		Counters[i] += other.Counters[i];
+	}
+}
+
+nlohmann::json ProfilerStats::ToJson() const
+{
+	nlohmann::json JData;
+	for (int i = 0; i < ProfilerStage::StageCount; i++)
+	{
+		ProfilerStage Stage = static_cast<ProfilerStage>(i);
+		JData["Stages"][Profiler::GetStageName(Stage)] = { {"Milliseconds", StageNanoseconds[i] / 1000000.0}, {"Calls", StageCalls[i]} };
+	}
+
+	for (int i = 0; i < ProfilerCounter::CounterCount; i++)
+	{
+		JData["Counters"][Profiler::GetCounterName(static_cast<ProfilerCounter>(i))] = Counters[i];
+	}
+	return JData;
+}
+
+void FrameSpread::Add(const ProfilerStats& frame)
+{
+	for (int i = 0; i < ProfilerStage::StageCount; i++)
+	{
+		MinimumNanoseconds[i] = FrameCount == 0 ? frame.StageNanoseconds[i] : std::min(MinimumNanoseconds[i], frame.StageNanoseconds[i]);
+		MaximumNanoseconds[i] = std::max(MaximumNanoseconds[i], frame.StageNanoseconds[i]);
+	}
+	Total.Add(frame);
+	FrameCount++;
+}
+
+nlohmann::json FrameSpread::ToJson() const
+{
+	nlohmann::json JData = nlohmann::json::object();
+	for (int i = 0; i < ProfilerStage::StageCount; i++)
+	{
+		double Average = FrameCount > 0 ? Total.StageNanoseconds[i] / 1000000.0 / FrameCount : 0.0;
+		JData[Profiler::GetStageName(static_cast<ProfilerStage>(i))] = { {"AverageMilliseconds", Average}, {"MinimumMilliseconds", MinimumNanoseconds[i] / 1000000.0},
+																		  {"MaximumMilliseconds", MaximumNanoseconds[i] / 1000000.0} };
+	}
+	return JData;
+}
+
+void Profiler::SetEnabled(const bool& value)
+{
+	bEnabled = value;
+}
+
+void Profiler::BeginFrame(const std::string& name)
+{
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	CurrentFrame = FrameReport();
+	CurrentFrame.Name = name;
+	bInFrame = true;
+}
+
+void Profiler::EndFrame()
+{
+	if (!bEnabled || !bInFrame)
+	{
+		return;
+	}
+
+	bInFrame = false;
+	std::lock_guard<std::mutex> Lock(ProfilerMutex);
+	RunStats.Add(CurrentFrame.Stats);
+	FrameTotals.Add(CurrentFrame.Stats);
+	if (Frames.size() < MaximumFrameReports)
+	{
+		Frames.push_back(CurrentFrame);
+	}
+}
+
+FrameReport Profiler::SuspendFrame()
+{
+	if (!bEnabled || !bInFrame)
+	{
+		return FrameReport();
+	}
+
+	bInFrame = false;
+	return CurrentFrame;
+}
+
+void Profiler::ResumeFrame(const FrameReport& report)
+{
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	CurrentFrame = report;
+	bInFrame = true;
+}
+
+void Profiler::AddStageTime(const ProfilerStage& stage, const long long& nanoseconds)
+{
+	if (bInFrame)
+	{
+		CurrentFrame.Stats.StageNanoseconds[stage] += nanoseconds;
+		CurrentFrame.Stats.StageCalls[stage]++;
+		return;
+	}
+
+	//Time outside of a frame like parsing the json goes straight to the run
+	std::lock_guard<std::mutex> Lock(ProfilerMutex);
+	RunStats.StageNanoseconds[stage] += nanoseconds;
+	RunStats.StageCalls[stage]++;
+}
+
+void Profiler::AddCount(const ProfilerCounter& counter, const long long& amount)
+{
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	if (bInFrame)
+	{
+		CurrentFrame.Stats.Counters[counter] += amount;
+		return;
+	}
+
+	std::lock_guard<std::mutex> Lock(ProfilerMutex);
+	RunStats.Counters[counter] += amount;
+}
+
+nlohmann::json Profiler::MakeReport()
+{
+	std::lock_guard<std::mutex> Lock(ProfilerMutex);
+	nlohmann::json Report = RunStats.ToJson();
+	Report["FrameCount"] = FrameTotals.FrameCount;
+	Report["FrameStages"] = FrameTotals.ToJson();
+	Report["WallMilliseconds"] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - RunStart).count();
+
+	Report["Frames"] = nlohmann::json::array();
+	for (const FrameReport& Frame : Frames)
+	{
+		nlohmann::json FrameData = Frame.Stats.ToJson();
+		FrameData["Name"] = Frame.Name;
+		Report["Frames"].push_back(FrameData);
+	}
+	return Report;
+}
+
+bool Profiler::WriteReport(const std::string& filename)
+{
+	std::ofstream File(filename);
+	if (!File.is_open())
+	{
+		printf("Couldn't write the profiler report to %s.\n", filename.c_str());
+		return false;
+	}
+
+	File << MakeReport().dump(4);
+	return true;
+}
+
+void Profiler::Reset()
+{
+	std::lock_guard<std::mutex> Lock(ProfilerMutex);
+	RunStats = ProfilerStats();
+	FrameTotals = FrameSpread();
+	Frames.clear();
+	RunStart = std::chrono::steady_clock::now();
+}
+
+const char* Profiler::GetStageName(const ProfilerStage& stage)
+{
+	switch (stage)
+	{
+	case ProfilerStage::StageParse:
+		return "Parse";
+	case ProfilerStage::StageDecode:
+		return "Decode";
+	case ProfilerStage::StageText:
+		return "Text";
+	case ProfilerStage::StageResize:
+		return "Resize";
+	case ProfilerStage::StageComposite:
+		return "Composite";
+	case ProfilerStage::StageConvert:
+		return "Convert";
+	case ProfilerStage::StageEncode:
+		return "Encode";
+	case ProfilerStage::StageFrame:
+		return "Frame";
+	default:
+		return "Unknown";
+	}
+}
+
+const char* Profiler::GetCounterName(const ProfilerCounter& counter)
+{
+	switch (counter)
+	{
+	case ProfilerCounter::CounterPixelsComposited:
+		return "PixelsComposited";
+	case ProfilerCounter::CounterBytesWritten:
+		return "BytesWritten";
+	case ProfilerCounter::CounterAssetCacheHits:
+		return "AssetCacheHits";
+	case ProfilerCounter::CounterAssetCacheMisses:
+		return "AssetCacheMisses";
+	case ProfilerCounter::CounterResizeCacheHits:
+		return "ResizeCacheHits";
+	case ProfilerCounter::CounterResizeCacheMisses:
+		return "ResizeCacheMisses";
+	case ProfilerCounter::CounterGlyphCacheHits:
+		return "GlyphCacheHits";
+	case ProfilerCounter::CounterGlyphCacheMisses:
+		return "GlyphCacheMisses";
+	case ProfilerCounter::CounterTextRunHits:
+		return "TextRunHits";
+	case ProfilerCounter::CounterTextRunMisses:
+		return "TextRunMisses";
+	default:
+		return "Unknown";
+	}
+}
+
+ScopedTimer::ScopedTimer(const ProfilerStage& stage)
+{
+	Stage = stage;
+	bActive = Profiler::IsEnabled();
+	if (bActive)
+	{
+		Start = std::chrono::steady_clock::now();
+	}
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	if (bActive)
+	{
+		Profiler::AddStageTime(Stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+	}
+}
@@ -31,35 +31,55 @@ int TextBlock::GetDataHeight()
 	return PixelHeight;
 }
 
-void TextBlock::SaveImage(const std::shared_ptr<Image>& image, const std::shared_ptr<Font>& font)
+bool TextBlock::PrepareData(const std::shared_ptr<Font>& font)
 {
 	if (font != nullptr || Text == "")
 	{
-		//Turn the text into an image and change it's color if we set a different one
-		std::shared_ptr<Image> TextImage = font->GetTextImage(Text, PixelHeight);
-		if (Color.get())
+		//Text that has been drawn before in the same color only costs a lookup, the width of the run is the measured width of the text
+		TextImage = font->GetTextRunImage(Text, PixelHeight, Color, Format, true);
+		if (TextImage != nullptr)
 		{
-			TextImage->ChangeColor(Color);
+			CalculatedWidth = TextImage->GetWidth();
+			return true;
 		}
-		
-		//Calculate the position from which we neeed to add the image
-		int TextWidthOffset = CalculateWidthOffset() - CalculateWidthAlignment();
-		int TextHeightOffset = CalculateHeightOffset() - CalculateHeightAlignment();
-		CalculateAndAddSnapCorrection(TextWidthOffset, TextHeightOffset);
-		image->CompositeImage(TextImage, TextWidthOffset, TextHeightOffset);
+
+		Shaped = font->ShapeText(Text, PixelHeight);
+		CalculatedWidth = Shaped.Width;
+		TextFont = font;
+		return true;
 	}
-	else
+
+	printf("There was no font or text given so no text can be saved in Block: %s.\n", Name.c_str());
+	return false;
+}
+
+void TextBlock::DrawData(const std::shared_ptr<Image>& image, const int& widthOffset, const int& heightOffset)
+{
+	if (TextImage != nullptr)
 	{
-		printf("There was no font or text given so no text can be saved in Block: %s.\n", Name.c_str());
+		image->CompositeImage(TextImage, widthOffset, heightOffset);
+		return;
 	}
 
-	BaseBlock::SaveImage(image, font);
+	//Like the runs the alpha of the color isn't used, without a color the text stays white
+	Pixel TextColor{ 1.0f, 1.0f, 1.0f, 1.0f };
+	if (Color.get())
+	{
+		TextColor = Pixel{ Color->r, Color->g, Color->b, 1.0f };
+	}
+	TextFont->DrawShapedText(image, Shaped, PixelHeight, TextColor, widthOffset, heightOffset);
 }
 
 void TextBlock::ClearData()
 {
+	//Reset to the same values a new block has so an image doesn't depend on the images that came before it
 	Text = "";
-	PixelHeight = 0;
+	PixelHeight = 16;
+	CalculatedWidth = 0;
 	Color = nullptr;
+	Format = PixelFormat::FormatFloat;
+	TextImage = nullptr;
+	TextFont = nullptr;
+	Shaped = ShapedText();
 	BaseBlock::ClearData();
 }
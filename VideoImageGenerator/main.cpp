@@ -1,10 +1,31 @@
 #include <iostream>
 #include "Header/Layout.h"
 #include "Header/Font.h"
+#include "Header/Profiler.h"
 #include <fstream>
 
-//TODO: Make an editor to make he .json creation easier
-int main() 
+//Prints how the program should be called
+static void PrintUsage()
+{
+	printf("Usage: VideoImageGenerator [--jobs N] [--shard i/N] [--stream] [--batch N] [--no-pipeline] [--no-static-layer] [--trim-images] [--sdf-text] [--compression N] [--output raw|y4m] [--output-file F] [--frame-rate N[/D]] [--report report.json] layout.json [layout2.json ...]\n");
+	printf("  --jobs N         Render N images at the same time, 0 uses every core. Overrides the Threads value in the json.\n");
+	printf("  --shard i/N      Only render the images whose index in the Images list modulo N is i, starting from 0.\n");
+	printf("  --stream         Render the images while the json is read so only a few of them are in memory, the Layout has to come before the Images.\n");
+	printf("  --batch N        The amount of images --stream reads before rendering them, 0 uses 4 per thread.\n");
+	printf("  --no-pipeline    Let every thread decode, compose and encode an image on its own instead of running those stages at the same time.\n");
+	printf("  --no-static-layer Draw every block for every image, even the blocks that have the same data in all of the images.\n");
+	printf("  --trim-images    Cut the transparent margins off of the StoredImages when they are loaded so they are quicker to resize and draw.\n");
+	printf("  --sdf-text       Scale every character from one signed distance field instead of rasterizing it for every text size, the edges are a bit softer.\n");
+	printf("  --compression N  The png compression level from 0 for none to 9 for the smallest files. Overrides the CompressionLevel value in the json.\n");
+	printf("  --output raw|y4m Write the images as the frames of one raw RGBA or Y4M stream in the order of the Images list instead of as png files.\n");
+	printf("  --output-file F  The file or named pipe the frames are written to, - is stdout which is the default. The messages go to stderr then.\n");
+	printf("  --frame-rate N   The frame rate put in the Y4M header, N/D for rates like 30000/1001. The default is 30.\n");
+	printf("  --report F       Write the time spent in every stage and the counters of the run and of every image to F as json.\n");
+	printf("Without any layout files the filepath will be asked for.\n");
+}
+
+//Asks for a single filepath like before there were any arguments
+static std::string AskFilepath()
 {
 	std::string Filepath = "";
 	bool bCorrectFilepath = false;
@@ -30,6 +51,207 @@ int main()
 		}
 	}
 
-	std::shared_ptr<Layout> LayoutTest(new Layout(nlohmann::json::parse(std::ifstream(Filepath))));
-	return 0;
-}
\ No newline at end of file
+	return Filepath;
+}
+
+//TODO: Make an editor to make he .json creation easier
+int main(int argc, char* argv[]) 
+{
+	LayoutSettings Settings;
+	std::vector<std::string> Filepaths;
+	std::string ReportFilepath = "";
+	bool bStream = false;
+	bool bFrameOutput = false;
+	FrameFormat OutputFormat = FrameFormat::FrameRaw;
+	std::string OutputFilepath = "-";
+	int FrameRate = 30;
+	int FrameRateDivisor = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string Argument = argv[i];
+		if (Argument == "--help" || Argument == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (Argument == "--jobs")
+		{
+			if (i + 1 >= argc || sscanf(argv[i + 1], "%d", &Settings.Threads) != 1 || Settings.Threads < 0)
+			{
+				printf("--jobs needs a number of threads that is 0 or higher.\n");
+				return 1;
+			}
+			i++;
+		}
+		else if (Argument == "--shard")
+		{
+			if (i + 1 >= argc || sscanf(argv[i + 1], "%d/%d", &Settings.ShardIndex, &Settings.ShardCount) != 2 || 
+				Settings.ShardCount < 1 || Settings.ShardIndex < 0 || Settings.ShardIndex >= Settings.ShardCount)
+			{
+				printf("--shard needs to be given as i/N where i is from 0 to N - 1.\n");
+				return 1;
+			}
+			i++;
+		}
+		else if (Argument == "--stream")
+		{
+			bStream = true;
+		}
+		else if (Argument == "--batch")
+		{
+			if (i + 1 >= argc || sscanf(argv[i + 1], "%d", &Settings.BatchSize) != 1 || Settings.BatchSize < 0)
+			{
+				printf("--batch needs a number of images that is 0 or higher.\n");
+				return 1;
+			}
+			i++;
+		}
+		else if (Argument == "--no-pipeline")
+		{
+			Settings.bPipeline = false;
+		}
+		else if (Argument == "--no-static-layer")
+		{
+			Settings.bStaticLayer = false;
+		}
+		else if (Argument == "--trim-images")
+		{
+			Settings.bTrimImages = true;
+		}
+		else if (Argument == "--sdf-text")
+		{
+			Settings.bSDFText = true;
+		}
+		else if (Argument == "--compression")
+		{
+			if (i + 1 >= argc || sscanf(argv[i + 1], "%d", &Settings.CompressionLevel) != 1 || Settings.CompressionLevel < 0 || Settings.CompressionLevel > 9)
+			{
+				printf("--compression needs a level from 0 to 9.\n");
+				return 1;
+			}
+			i++;
+		}
+		else if (Argument == "--output")
+		{
+			std::string Format = i + 1 < argc ? argv[i + 1] : "";
+			if (Format != "raw" && Format != "y4m")
+			{
+				printf("--output needs to be raw or y4m.\n");
+				return 1;
+			}
+			bFrameOutput = true;
+			OutputFormat = Format == "y4m" ? FrameFormat::FrameY4M : FrameFormat::FrameRaw;
+			i++;
+		}
+		else if (Argument == "--output-file")
+		{
+			if (i + 1 >= argc)
+			{
+				printf("--output-file needs a filepath or - for stdout.\n");
+				return 1;
+			}
+			OutputFilepath = argv[++i];
+		}
+		else if (Argument == "--frame-rate")
+		{
+			FrameRateDivisor = 1;
+			if (i + 1 >= argc || sscanf(argv[i + 1], "%d/%d", &FrameRate, &FrameRateDivisor) < 1 || FrameRate < 1 || FrameRateDivisor < 1)
+			{
+				printf("--frame-rate needs a frame rate above 0 given as N or N/D.\n");
+				return 1;
+			}
+			i++;
+		}
+		else if (Argument == "--report")
+		{
+			if (i + 1 >= argc)
+			{
+				printf("--report needs a filepath to write the report to.\n");
+				return 1;
+			}
+			ReportFilepath = argv[++i];
+		}
+		else if (Argument.size() > 2 && Argument.substr(0, 2) == "--")
+		{
+			printf("Unknown argument %s.\n", Argument.c_str());
+			PrintUsage();
+			return 1;
+		}
+		else
+		{
+			Filepaths.push_back(Argument);
+		}
+	}
+
+	if (Filepaths.empty())
+	{
+		Filepaths.push_back(AskFilepath());
+	}
+
+	//Every layout writes to the same stream so the frames of multiple files end up one after the other
+	if (bFrameOutput)
+	{
+		Settings.Writer = std::shared_ptr<FrameWriter>(new FrameWriter(OutputFilepath, OutputFormat, FrameRate, FrameRateDivisor));
+		if (!Settings.Writer->IsOpen())
+		{
+			return 1;
+		}
+	}
+
+	if (!ReportFilepath.empty())
+	{
+		Profiler::SetEnabled(true);
+		Profiler::Reset();
+	}
+
+	//A file that can't be used is skipped so the rest of the batch still gets rendered, the exit code tells that something went wrong
+	int Result = 0;
+	for (const std::string& Filepath : Filepaths)
+	{
+		std::ifstream File(Filepath);
+		if (!File.is_open())
+		{
+			printf("Couldn't open %s.\n", Filepath.c_str());
+			Result = 1;
+			continue;
+		}
+
+		if (bStream)
+		{
+			std::shared_ptr<Layout> CurrentLayout(new Layout(File, Settings));
+			if (!CurrentLayout->IsValid())
+			{
+				printf("%s isn't a valid layout json, it needs a Layout and an Images list.\n", Filepath.c_str());
+				Result = 1;
+			}
+			continue;
+		}
+
+		nlohmann::json JData;
+		{
+			ScopedTimer Timer(ProfilerStage::StageParse);
+			JData = nlohmann::json::parse(File, nullptr, false);
+		}
+		if (JData.is_discarded() || !JData.contains("Layout") || !JData.contains("Images"))
+		{
+			printf("%s isn't a valid layout json, it needs a Layout and an Images list.\n", Filepath.c_str());
+			Result = 1;
+			continue;
+		}
+
+		std::shared_ptr<Layout> CurrentLayout(new Layout(JData, Settings));
+	}
+
+	if (Settings.Writer != nullptr && !Settings.Writer->Flush())
+	{
+		Result = 1;
+	}
+
+	if (!ReportFilepath.empty() && !Profiler::WriteReport(ReportFilepath))
+	{
+		Result = 1;
+	}
+
+	return Result;
+}
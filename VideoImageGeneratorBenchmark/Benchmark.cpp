@@ -0,0 +1,538 @@
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include "../VideoImageGenerator/Header/Layout.h"
+#include "../VideoImageGenerator/Header/AssetCache.h"
+#include "../VideoImageGenerator/Header/Profiler.h"
+#include "../VideoImageGenerator/Header/PixelKernels.h"
+#include "../VideoImageGenerator/Header/PngEncoder.h"
+#include "../VideoImageGenerator/Header/FrameWriter.h"
+
+//Everything that can be changed from the command line
+struct BenchmarkOptions
+{
+	bool bQuick = false;
+	bool bMicro = true;
+	bool bMacro = true;
+	std::string OutputPath = "BenchmarkOutput/";
+	std::string FontPath = "";
+
+	//The synthetic layout of the macro benchmark
+	int Blocks = 32;
+	int Depth = 3;
+	int Frames = 64;
+	int Width = 1920;
+	int Height = 1080;
+	int Threads = 0;
+	bool bPipeline = true;
+	bool bStaticLayer = true;
+	int StaticPercent = 0;
+	int CompressionLevel = -1;
+	PixelFormat Format = PixelFormat::FormatFloat;
+};
+
+static void PrintUsage()
+{
+	printf("Usage: VideoImageGeneratorBenchmark [options]\n");
+	printf("  --quick            Small sizes and short runs, used as a smoke test\n");
+	printf("  --micro / --macro  Only run the micro or the macro benchmarks\n");
+	printf("  --out DIR          Directory for the generated assets and images (default BenchmarkOutput/)\n");
+	printf("  --font FILE        Font to use, without one the text benchmarks are skipped if no system font is found\n");
+	printf("  --blocks N         Blocks in the synthetic layout (default 32)\n");
+	printf("  --depth D          How deep the blocks are nested (default 3)\n");
+	printf("  --frames M         Images rendered by the macro benchmark (default 64)\n");
+	printf("  --resolution WxH   Size of the rendered images (default 1920x1080)\n");
+	printf("  --jobs N           Threads of the macro benchmark, 0 uses every core (default 0)\n");
+	printf("  --no-pipeline      Render the macro benchmark without the decode, compose and encode pipeline\n");
+	printf("  --static P         Percentage of the top blocks that have the same data in every image (default 0)\n");
+	printf("  --no-static-layer  Draw the blocks that are the same in every image for every image as well\n");
+	printf("  --compression N    The png compression level of the macro benchmark from 0 to 9\n");
+	printf("  --format F         0 for Float and 1 for RGBA8 images in the macro benchmark (default 0)\n");
+}
+
+//Runs the function until the minimum time has passed and returns the average seconds per call, the first call is a warm up
+static double MeasureSeconds(const std::function<void()>& function, const double& minimumSeconds)
+{
+	function();
+
+	int Calls = 0;
+	double Elapsed = 0.0;
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	while (Calls == 0 || Elapsed < minimumSeconds)
+	{
+		function();
+		Calls++;
+		Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	}
+
+	return Elapsed / Calls;
+}
+
+static void PrintResult(const std::string& name, const double& seconds, const double& amount, const char* unit)
+{
+	printf("%-44s %10.3f ms %12.2f %s\n", name.c_str(), seconds * 1000.0, amount / seconds, unit);
+}
+
+static const char* GetFormatName(const PixelFormat& format)
+{
+	return format == PixelFormat::FormatRGBA8 ? "RGBA8" : "Float";
+}
+
+//Makes a diagonal gradient with an alpha that goes from the top to the bottom so the blending can't skip any pixels
+static std::shared_ptr<unsigned char> MakeGradientData(const int& width, const int& height, const int& seed)
+{
+	std::shared_ptr<unsigned char> Data(new unsigned char[width * height * 4], std::default_delete<unsigned char[]>());
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char* CurrentPixel = Data.get() + (y * width + x) * 4;
+			CurrentPixel[0] = static_cast<unsigned char>((x * 255 / std::max(1, width - 1) + seed * 40) % 256);
+			CurrentPixel[1] = static_cast<unsigned char>((y * 255 / std::max(1, height - 1) + seed * 80) % 256);
+			CurrentPixel[2] = static_cast<unsigned char>(((x + y) * 127 / std::max(1, width + height - 2) + seed * 20) % 256);
+			CurrentPixel[3] = static_cast<unsigned char>(64 + y * 191 / std::max(1, height - 1));
+		}
+	}
+	return Data;
+}
+
+static std::string FindFont(const BenchmarkOptions& options)
+{
+	if (!options.FontPath.empty())
+	{
+		return options.FontPath;
+	}
+
+	const char* Candidates[] = { "C:/Windows/Fonts/arial.ttf", "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf", "/usr/share/fonts/TTF/DejaVuSans.ttf",
+								 "/usr/share/fonts/dejavu/DejaVuSans.ttf", "/Library/Fonts/Arial.ttf", "/System/Library/Fonts/Supplemental/Arial.ttf" };
+	for (const char* Candidate : Candidates)
+	{
+		if (std::filesystem::exists(Candidate))
+		{
+			return Candidate;
+		}
+	}
+	return "";
+}
+
+static void RunMicroBenchmarks(const BenchmarkOptions& options, const std::string& fontPath)
+{
+	double MinimumSeconds = options.bQuick ? 0.02 : 0.5;
+	int Width = options.bQuick ? 320 : 1920;
+	int Height = options.bQuick ? 180 : 1080;
+	int OverlaySize = options.bQuick ? 64 : 512;
+	double FramePixels = static_cast<double>(Width) * Height;
+
+	printf("\nMicro benchmarks (%dx%d)\n", Width, Height);
+	printf("%-44s %13s %12s\n", "Benchmark", "Time/call", "Throughput");
+
+	std::shared_ptr<unsigned char> FrameData = MakeGradientData(Width, Height, 0);
+	std::shared_ptr<unsigned char> OverlayData = MakeGradientData(OverlaySize, OverlaySize, 1);
+
+	for (PixelFormat Format : { PixelFormat::FormatFloat, PixelFormat::FormatRGBA8 })
+	{
+		std::string Suffix = std::string(" (") + GetFormatName(Format) + ")";
+
+		//Decoding a PNG ends in UnsignedCharToImageData so this is measured through the constructor that takes the data
+		double Seconds = MeasureSeconds([&]() { Image Converted(FrameData, Width, Height, 4, false, Format); }, MinimumSeconds);
+		PrintResult("UnsignedCharToImageData" + Suffix, Seconds, FramePixels / 1000000.0, "MPix/s");
+
+		Image Background(FrameData, Width, Height, 4, false, Format);
+		std::shared_ptr<Image> Overlay(new Image(OverlayData, OverlaySize, OverlaySize, 4, false, Format));
+		Seconds = MeasureSeconds([&]() { Background.CompositeImage(Overlay, Width / 4, Height / 4); }, MinimumSeconds);
+		PrintResult("CompositeImage " + std::to_string(OverlaySize) + "x" + std::to_string(OverlaySize) + Suffix, Seconds, static_cast<double>(OverlaySize) * OverlaySize / 1000000.0, "MPix/s");
+
+		std::shared_ptr<Image> FullOverlay(new Image(FrameData, Width, Height, 4, false, Format));
+		Seconds = MeasureSeconds([&]() { Background.CompositeImage(FullOverlay); }, MinimumSeconds);
+		PrintResult("CompositeImage full frame" + Suffix, Seconds, FramePixels / 1000000.0, "MPix/s");
+
+		//The resize happens on a copy every call since it changes the image, the copy is a small part of the time
+		std::shared_ptr<Image> ResizeSource(new Image(OverlayData, OverlaySize, OverlaySize, 4, false, Format));
+		Seconds = MeasureSeconds([&]()
+			{
+				Image Resized;
+				Resized.CopyValue(ResizeSource);
+				Resized.ResizeImage(OverlaySize * 3 / 4, OverlaySize / 2);
+			}, MinimumSeconds);
+		PrintResult("ResizeImage to 3/4x1/2" + Suffix, Seconds, static_cast<double>(OverlaySize) * OverlaySize / 1000000.0, "MPix/s");
+
+		std::string SavePath = options.OutputPath + "MicroSave.png";
+		Seconds = MeasureSeconds([&]() { Background.SaveImage(SavePath); }, MinimumSeconds);
+		PrintResult("SaveImage" + Suffix, Seconds, FramePixels * 4 / 1000000.0, "MB/s raw");
+
+		//The saved file is in the page cache after the first call so this is the decode from the mapping without the disk
+		Seconds = MeasureSeconds([&]() { Image Loaded(SavePath, Format); }, MinimumSeconds);
+		PrintResult("LoadImage" + Suffix, Seconds, FramePixels / 1000000.0, "MPix/s");
+
+		//The work done for every frame of a stream instead of SaveImage
+		for (FrameFormat OutputFormat : { FrameFormat::FrameRaw, FrameFormat::FrameY4M })
+		{
+			Seconds = MeasureSeconds([&]() { FrameWriter::ConvertFrame(FullOverlay, OutputFormat, Width, Height); }, MinimumSeconds);
+			PrintResult(std::string("ConvertFrame ") + (OutputFormat == FrameFormat::FrameY4M ? "y4m" : "raw") + Suffix, Seconds, FramePixels / 1000000.0, "MPix/s");
+		}
+	}
+
+	//The encoder is timed on its own for every level with one thread and with every core, the size shows what the level gains
+	int DefaultLevel = PngEncoder::GetCompressionLevel();
+	int DefaultThreads = PngEncoder::GetThreads();
+	for (int Level : { 0, 1, 3, 6, 9 })
+	{
+		for (int Threads : { 1, 0 })
+		{
+			PngEncoder::SetCompressionLevel(Level);
+			PngEncoder::SetThreads(Threads);
+			size_t Size = 0;
+			double Seconds = MeasureSeconds([&]() { Size = PngEncoder::Encode(FrameData.get(), Width, Height).size(); }, MinimumSeconds);
+			PrintResult("PngEncoder level " + std::to_string(Level) + (Threads == 1 ? ", 1 thread" : ", all cores") + " (" + std::to_string(Size / 1024) + " KB)",
+						Seconds, FramePixels * 4 / 1000000.0, "MB/s raw");
+		}
+	}
+	PngEncoder::SetCompressionLevel(DefaultLevel);
+	PngEncoder::SetThreads(DefaultThreads);
+
+	if (fontPath.empty())
+	{
+		printf("No font found so GetTextImage is skipped, use --font to give one.\n");
+		return;
+	}
+
+	Font TextFont(fontPath);
+	std::string Text = "The quick brown fox jumps over the lazy dog 0123456789";
+	for (int PixelHeight : { 16, 48, 128 })
+	{
+		double Seconds = MeasureSeconds([&]() { TextFont.GetTextImage(Text, PixelHeight); }, MinimumSeconds);
+		PrintResult("GetTextImage " + std::to_string(PixelHeight) + "px", Seconds, static_cast<double>(Text.size()), "chars/s");
+	}
+
+	//The fields are made in the warm up call so this is only the scaling of the fields to the pixel height
+	Font FieldFont(fontPath, true);
+	for (int PixelHeight : { 16, 48, 128 })
+	{
+		double Seconds = MeasureSeconds([&]() { FieldFont.GetTextImage(Text, PixelHeight); }, MinimumSeconds);
+		PrintResult("GetTextImage " + std::to_string(PixelHeight) + "px (SDF)", Seconds, static_cast<double>(Text.size()), "chars/s");
+	}
+
+	double LengthSeconds = MeasureSeconds([&]() { TextFont.GetStringLength(Text, 48); }, MinimumSeconds);
+	PrintResult("GetStringLength 48px", LengthSeconds, static_cast<double>(Text.size()), "chars/s");
+
+	//After the first call a repeated label is only a lookup, this is what a TextBlock pays for it every frame
+	std::shared_ptr<Pixel> TextColor(new Pixel{ 1.0f, 0.5f, 0.0f, 1.0f });
+	for (PixelFormat Format : { PixelFormat::FormatFloat, PixelFormat::FormatRGBA8 })
+	{
+		double Seconds = MeasureSeconds([&]() { TextFont.GetTextRunImage(Text, 48, TextColor, Format); }, MinimumSeconds);
+		PrintResult(std::string("GetTextRunImage 48px (") + GetFormatName(Format) + ")", Seconds, static_cast<double>(Text.size()), "chars/s");
+	}
+
+	//Text that is only drawn once skips the run and its characters are blended straight onto the frame
+	ShapedText Shaped = TextFont.ShapeText(Text, 48);
+	for (PixelFormat Format : { PixelFormat::FormatFloat, PixelFormat::FormatRGBA8 })
+	{
+		std::shared_ptr<Image> Canvas(new Image{ Width, Height, Format });
+		double Seconds = MeasureSeconds([&]() { TextFont.DrawShapedText(Canvas, Shaped, 48, *TextColor); }, MinimumSeconds);
+		PrintResult(std::string("DrawShapedText 48px (") + GetFormatName(Format) + ")", Seconds, static_cast<double>(Text.size()), "chars/s");
+	}
+
+	//The same direct drawing with the glyphs scaled from the fields, after the warm up call both fonts take their glyphs from the cache
+	std::shared_ptr<Image> TextCanvas(new Image{ Width, Height, PixelFormat::FormatRGBA8 });
+	for (int PixelHeight : { 16, 48, 128 })
+	{
+		ShapedText SizedShaped = TextFont.ShapeText(Text, PixelHeight);
+		double Seconds = MeasureSeconds([&]() { TextFont.DrawShapedText(TextCanvas, SizedShaped, PixelHeight, *TextColor); }, MinimumSeconds);
+		PrintResult("DrawShapedText " + std::to_string(PixelHeight) + "px (raster)", Seconds, static_cast<double>(Text.size()), "chars/s");
+		Seconds = MeasureSeconds([&]() { FieldFont.DrawShapedText(TextCanvas, SizedShaped, PixelHeight, *TextColor); }, MinimumSeconds);
+		PrintResult("DrawShapedText " + std::to_string(PixelHeight) + "px (SDF)", Seconds, static_cast<double>(Text.size()), "chars/s");
+	}
+
+	//A copied section has no row spans so it shows what compositing the same text costs when every pixel is blended
+	Image TextBackground(FrameData, Width, Height, 4, false, PixelFormat::FormatFloat);
+	for (int PixelHeight : { 48, 128 })
+	{
+		std::shared_ptr<Image> TextImage = TextFont.GetTextImage(Text, PixelHeight);
+		std::shared_ptr<Image> BlendedTextImage = TextImage->CopyImageSection(TextImage->GetWidth(), TextImage->GetHeight());
+		double TextPixels = static_cast<double>(TextImage->GetWidth()) * TextImage->GetHeight() / 1000000.0;
+		double Seconds = MeasureSeconds([&]() { TextBackground.CompositeImage(TextImage); }, MinimumSeconds);
+		PrintResult("CompositeImage text " + std::to_string(PixelHeight) + "px", Seconds, TextPixels, "MPix/s");
+		Seconds = MeasureSeconds([&]() { TextBackground.CompositeImage(BlendedTextImage); }, MinimumSeconds);
+		PrintResult("CompositeImage text " + std::to_string(PixelHeight) + "px without spans", Seconds, TextPixels, "MPix/s");
+	}
+}
+
+//Adds the blocks to the layout and the matching data to every image, every level gets an equal share of the blocks that are left.
+//The first blocks get the same data in every image, like a logo or a label would, and so do the blocks linked to them
+static void AddSyntheticBlocks(nlohmann::json& layoutBlocks, std::vector<nlohmann::json>& frameBlocks, int& blocksLeft, const int& depth, const bool& bText,
+							   const int& staticPercent, const BenchmarkOptions& options, std::mt19937& random)
+{
+	int Children = depth <= 1 ? blocksLeft : std::max(1, static_cast<int>(std::ceil(std::pow(static_cast<double>(blocksLeft), 1.0 / depth))));
+	int StaticChildren = (std::min(Children, blocksLeft) * staticPercent + 50) / 100;
+	const int ImageSizes[] = { 64, 128, 192, 256 };
+	const char* Words[] = { "Hello", "Frame", "Benchmark", "0123456789", "Layout", "quick brown fox" };
+
+	for (int i = 0; i < Children && blocksLeft > 0; i++)
+	{
+		blocksLeft--;
+		std::string Name = "Block" + std::to_string(blocksLeft);
+		bool bTextBlock = bText && random() % 3 == 0;
+		bool bStatic = i < StaticChildren;
+
+		nlohmann::json Block;
+		Block["Type"] = bTextBlock ? "TextBlock" : "ImageBlock";
+		Block["Name"] = Name;
+		Block["WidthOffset"] = static_cast<int>(random() % std::max(1, options.Width / 4));
+		Block["HeightOffset"] = static_cast<int>(random() % std::max(1, options.Height / 4));
+		Block["Alignment"] = static_cast<int>(random() % 9);
+		Block["SnapSide"] = static_cast<int>(random() % 5);
+		if (!bTextBlock)
+		{
+			Block["Width"] = ImageSizes[random() % 4];
+			Block["Height"] = ImageSizes[random() % 4];
+		}
+
+		//Every image gets its own data for the block
+		std::vector<nlohmann::json> ChildFrameBlocks(frameBlocks.size());
+		for (int frame = 0; frame < frameBlocks.size(); frame++)
+		{
+			if (bStatic && frame > 0)
+			{
+				ChildFrameBlocks[frame] = ChildFrameBlocks[0];
+				continue;
+			}
+
+			nlohmann::json Data;
+			Data["Name"] = Name;
+			if (bTextBlock)
+			{
+				Data["Text"] = Words[random() % 6];
+				Data["PixelHeight"] = 16 + static_cast<int>(random() % 48);
+			}
+			else
+			{
+				Data["StoredImage"] = options.OutputPath + "Asset" + std::to_string(random() % 4) + ".png";
+				Data["RetainAspectRatio"] = random() % 2 == 0;
+			}
+			ChildFrameBlocks[frame] = Data;
+		}
+
+		if (depth > 1 && blocksLeft > 0)
+		{
+			nlohmann::json ChildBlocks = nlohmann::json::array();
+			int ChildBudget = std::min(blocksLeft, std::max(1, blocksLeft / std::max(1, Children - i)));
+			int ChildBlocksLeft = ChildBudget;
+			std::vector<nlohmann::json> GrandChildFrameBlocks(frameBlocks.size(), nlohmann::json::array());
+			AddSyntheticBlocks(ChildBlocks, GrandChildFrameBlocks, ChildBlocksLeft, depth - 1, bText, bStatic ? 100 : 0, options, random);
+			blocksLeft -= ChildBudget - ChildBlocksLeft;
+
+			if (!ChildBlocks.empty())
+			{
+				Block["Blocks"] = ChildBlocks;
+				for (int frame = 0; frame < frameBlocks.size(); frame++)
+				{
+					ChildFrameBlocks[frame]["Blocks"] = GrandChildFrameBlocks[frame];
+				}
+			}
+		}
+
+		layoutBlocks.push_back(Block);
+		for (int frame = 0; frame < frameBlocks.size(); frame++)
+		{
+			frameBlocks[frame].push_back(ChildFrameBlocks[frame]);
+		}
+	}
+}
+
+static void RunMacroBenchmark(const BenchmarkOptions& options, const std::string& fontPath)
+{
+	printf("\nMacro benchmark: %d blocks (%d%% static), depth %d, %d images of %dx%d, %s, %d threads%s%s\n", options.Blocks, options.StaticPercent, options.Depth, options.Frames,
+		   options.Width, options.Height, GetFormatName(options.Format), options.Threads, options.bPipeline ? "" : ", no pipeline", options.bStaticLayer ? "" : ", no static layer");
+
+	//Write the assets the layout uses so the decoding is part of the measurement like it would be in a real run
+	std::string FramePath = options.OutputPath + "Frames/";
+	std::filesystem::create_directories(FramePath);
+	Image(MakeGradientData(options.Width, options.Height, 3), options.Width, options.Height).SaveImage(options.OutputPath + "Background.png");
+	for (int i = 0; i < 4; i++)
+	{
+		int AssetSize = 96 + 64 * i;
+		Image(MakeGradientData(AssetSize, AssetSize, i), AssetSize, AssetSize).SaveImage(options.OutputPath + "Asset" + std::to_string(i) + ".png");
+	}
+
+	std::mt19937 Random(1234);
+	nlohmann::json LayoutBlocks = nlohmann::json::array();
+	std::vector<nlohmann::json> FrameBlocks(options.Frames, nlohmann::json::array());
+	int BlocksLeft = options.Blocks;
+	AddSyntheticBlocks(LayoutBlocks, FrameBlocks, BlocksLeft, std::max(1, options.Depth), !fontPath.empty(), options.StaticPercent, options, Random);
+
+	nlohmann::json JData;
+	JData["Layout"]["SaveFilePath"] = FramePath;
+	JData["Layout"]["Background Image"] = options.OutputPath + "Background.png";
+	JData["Layout"]["PixelFormat"] = options.Format;
+	JData["Layout"]["Blocks"] = LayoutBlocks;
+	if (!fontPath.empty())
+	{
+		JData["Layout"]["Font"] = fontPath;
+	}
+
+	JData["Images"] = nlohmann::json::array();
+	for (int frame = 0; frame < options.Frames; frame++)
+	{
+		JData["Images"].push_back({ {"Filename", "Frame" + std::to_string(frame)}, {"Data", FrameBlocks[frame]} });
+	}
+
+	LayoutSettings Settings;
+	Settings.Threads = options.Threads;
+	Settings.bPipeline = options.bPipeline;
+	Settings.bStaticLayer = options.bStaticLayer;
+	Settings.CompressionLevel = options.CompressionLevel;
+	AssetCache::Clear();
+	Profiler::SetEnabled(true);
+	Profiler::Reset();
+
+	fflush(stdout);
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	{
+		Layout BenchmarkLayout(JData, Settings);
+	}
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+	Profiler::SetEnabled(false);
+	nlohmann::json Report = Profiler::MakeReport();
+	double BytesWritten = Report.at("Counters").at("BytesWritten").get<double>();
+	double RawBytes = static_cast<double>(options.Width) * options.Height * 4 * options.Frames;
+
+	printf("\n%-44s %10.3f s\n", "Total time", Seconds);
+	printf("%-44s %10.2f\n", "Images/s", options.Frames / Seconds);
+	printf("%-44s %10.2f\n", "MB/s of PNG written", BytesWritten / 1000000.0 / Seconds);
+	printf("%-44s %10.2f\n", "MB/s of raw RGBA8 pixels", RawBytes / 1000000.0 / Seconds);
+
+	//The stages are summed over every thread so they can add up to more than the total time
+	printf("\nTime per stage summed over all threads\n");
+	for (auto& Stage : Report.at("Stages").items())
+	{
+		printf("%-44s %10.3f ms %8lld calls\n", Stage.key().c_str(), Stage.value().at("Milliseconds").get<double>(), Stage.value().at("Calls").get<long long>());
+	}
+	for (auto& Counter : Report.at("Counters").items())
+	{
+		printf("%-44s %14lld\n", Counter.key().c_str(), Counter.value().get<long long>());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkOptions Options;
+	bool bBlocksSet = false;
+	bool bFramesSet = false;
+	bool bResolutionSet = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string Argument = argv[i];
+		bool bHasValue = i + 1 < argc;
+		if (Argument == "--help" || Argument == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (Argument == "--quick")
+		{
+			Options.bQuick = true;
+		}
+		else if (Argument == "--micro")
+		{
+			Options.bMacro = false;
+		}
+		else if (Argument == "--macro")
+		{
+			Options.bMicro = false;
+		}
+		else if (Argument == "--out" && bHasValue)
+		{
+			Options.OutputPath = (std::filesystem::path(argv[++i]) / "").string();
+		}
+		else if (Argument == "--font" && bHasValue)
+		{
+			Options.FontPath = argv[++i];
+		}
+		else if (Argument == "--blocks" && bHasValue)
+		{
+			Options.Blocks = std::max(1, atoi(argv[++i]));
+			bBlocksSet = true;
+		}
+		else if (Argument == "--depth" && bHasValue)
+		{
+			Options.Depth = std::max(1, atoi(argv[++i]));
+		}
+		else if (Argument == "--frames" && bHasValue)
+		{
+			Options.Frames = std::max(1, atoi(argv[++i]));
+			bFramesSet = true;
+		}
+		else if (Argument == "--resolution" && bHasValue)
+		{
+			if (sscanf(argv[++i], "%dx%d", &Options.Width, &Options.Height) != 2 || Options.Width < 1 || Options.Height < 1)
+			{
+				printf("--resolution needs to be given as WxH.\n");
+				return 1;
+			}
+			bResolutionSet = true;
+		}
+		else if (Argument == "--jobs" && bHasValue)
+		{
+			Options.Threads = std::max(0, atoi(argv[++i]));
+		}
+		else if (Argument == "--no-pipeline")
+		{
+			Options.bPipeline = false;
+		}
+		else if (Argument == "--no-static-layer")
+		{
+			Options.bStaticLayer = false;
+		}
+		else if (Argument == "--static" && bHasValue)
+		{
+			Options.StaticPercent = std::clamp(atoi(argv[++i]), 0, 100);
+		}
+		else if (Argument == "--compression" && bHasValue)
+		{
+			Options.CompressionLevel = std::clamp(atoi(argv[++i]), 0, 9);
+		}
+		else if (Argument == "--format" && bHasValue)
+		{
+			Options.Format = atoi(argv[++i]) == 1 ? PixelFormat::FormatRGBA8 : PixelFormat::FormatFloat;
+		}
+		else
+		{
+			printf("Unknown argument %s.\n", Argument.c_str());
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	//The quick run only makes sure everything works so it uses a tiny layout unless something else was asked for
+	if (Options.bQuick)
+	{
+		Options.Blocks = bBlocksSet ? Options.Blocks : 8;
+		Options.Frames = bFramesSet ? Options.Frames : 4;
+		Options.Width = bResolutionSet ? Options.Width : 320;
+		Options.Height = bResolutionSet ? Options.Height : 180;
+	}
+
+	std::filesystem::create_directories(Options.OutputPath);
+	std::string FontPath = FindFont(Options);
+	if (!FontPath.empty() && !std::filesystem::exists(FontPath))
+	{
+		printf("Font %s doesn't exist.\n", FontPath.c_str());
+		return 1;
+	}
+	printf("Kernels: %d (0 scalar, 1 SSE4.1, 2 AVX2), font: %s\n", PixelKernels::GetInstructionSet(), FontPath.empty() ? "none" : FontPath.c_str());
+
+	if (Options.bMicro)
+	{
+		RunMicroBenchmarks(Options, FontPath);
+	}
+
+	if (Options.bMacro)
+	{
+		RunMacroBenchmark(Options, FontPath);
+	}
+
+	return 0;
+}
@@ -1,11 +1,20 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include "../VideoImageGenerator/Header/Image.h"
 #include "../VideoImageGenerator/Header/Font.h"
 #include "../VideoImageGenerator/Header/Layout.h"
 #include "../VideoImageGenerator/Header/ImageBlock.h"
 #include "../VideoImageGenerator/Header/TextBlock.h"
+#include "../VideoImageGenerator/Header/PixelKernels.h"
+#include "../VideoImageGenerator/Header/AssetCache.h"
+#include "../VideoImageGenerator/Header/Profiler.h"
+#include "../VideoImageGenerator/Header/BoundedQueue.h"
+#include "../VideoImageGenerator/Header/PngEncoder.h"
+#include "../VideoImageGenerator/Header/FrameWriter.h"
+#include "../VideoImageGenerator/Header/MappedFile.h"
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 //To get the classes to be properly linked this has to be followed: https://learn.microsoft.com/en-us/visualstudio/test/how-to-use-microsoft-test-framework-for-cpp?view=vs-2022#object_files
 
@@ -20,7 +29,7 @@ namespace VideoImageGeneratorUnitTests
 			int Height = 4;
 			int Components = 4;
 
-			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components]);
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components], std::default_delete<unsigned char[]>());
 			for (int i = 0; i < Width * Height; i++)
 			{
 				TestImageData.get()[Components * i] = 255;
@@ -56,7 +65,7 @@ namespace VideoImageGeneratorUnitTests
 			int Width = 4;
 			int Height = 4;
 			int Components = 4;
-			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components]);
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components], std::default_delete<unsigned char[]>());
 			for (int i = 0; i < Width * Height; i++)
 			{
 				TestImageData.get()[Components * i] = 255;
@@ -222,7 +231,8 @@ namespace VideoImageGeneratorUnitTests
 			//emove the bottom half of the image before changing the color to see if it properly works with the alpha channel
 			Image Test("../../UnitTestImages/Test.png");
 			Pixel GreenPixel{ 0.0f, 1.0f, 0.0f, 1.0f };
-			Pixel InvisibleGreenPixel{ 0.0f, 1.0f, 0.0f, 0.0f};
+			//The pixels are premultiplied so the color of a pixel without alpha stays empty
+			Pixel InvisibleGreenPixel{ 0.0f, 0.0f, 0.0f, 0.0f};
 
 			Test.EraseImageSection(4, 2, 0, 2);
 			Test.ChangeColor(std::make_shared<Pixel>(GreenPixel));
@@ -274,7 +284,7 @@ namespace VideoImageGeneratorUnitTests
 			int Height = 2;
 			int Components = 4;
 
-			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components]);
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components], std::default_delete<unsigned char[]>());
 			for (int i = 0; i < Width * Height; i++)
 			{
 				TestImageData.get()[Components * i] = 0;
@@ -308,6 +318,491 @@ namespace VideoImageGeneratorUnitTests
 			}
 			Assert::IsTrue(Correct, L"The images didn't composite together");
 		}
+
+		TEST_METHOD(PackedCompositeImageTest)
+		{
+			Image Test("../../UnitTestImages/Test.png", PixelFormat::FormatRGBA8);
+			Image GreenRectangle(4, 2, PixelFormat::FormatRGBA8);
+			GreenRectangle.ChangeColor(std::make_shared<Pixel>(Pixel{ 0.0f, 1.0f, 0.0f, 1.0f }), true);
+
+			Test.CompositeImage(std::make_shared<Image>(GreenRectangle), 0, 2);
+			unsigned char RedPixel[4]{ 255, 0, 0, 255 };
+			unsigned char GreenPixel[4]{ 0, 255, 0, 255 };
+			bool Correct = Test.GetData() == nullptr;
+
+			for (int i = 0; i < Test.GetWidth() * Test.GetHeight(); i++)
+			{
+				if (memcmp(Test.GetPackedData().get() + i * 4, i < 8 ? RedPixel : GreenPixel, 4) != 0)
+				{
+					Correct = false;
+				}
+			}
+			Assert::IsTrue(Correct, L"The RGBA8 images didn't composite together");
+		}
+
+		TEST_METHOD(ConvertFormatTest)
+		{
+			Image Test("../../UnitTestImages/Test.png");
+			Test.ConvertFormat(PixelFormat::FormatRGBA8);
+			Test.ConvertFormat(PixelFormat::FormatFloat);
+			Pixel RedPixel{ 1.0f, 0.0f, 0.0f, 1.0f };
+			bool Correct = Test.GetFormat() == PixelFormat::FormatFloat;
+
+			for (int i = 0; i < Test.GetWidth() * Test.GetHeight(); i++)
+			{
+				if (Test.GetData().get()[i] != RedPixel)
+				{
+					Correct = false;
+				}
+			}
+			Assert::IsTrue(Correct, L"The pixels changed when converting between formats");
+		}
+
+		TEST_METHOD(RowSpansTest)
+		{
+			//A row with transparent, opaque and half transparent pixels and a row that is completely transparent
+			int Width = 20;
+			int Height = 2;
+			int Components = 4;
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components](), std::default_delete<unsigned char[]>());
+			for (int i = 4; i < 18; i++)
+			{
+				TestImageData.get()[Components * i + 1] = 255;
+				TestImageData.get()[Components * i + 3] = i < 16 ? 255 : 128;
+			}
+
+			//The section is a copy of the same pixels without any spans so it is blended the way it was done before there were spans
+			for (PixelFormat Format : { PixelFormat::FormatFloat, PixelFormat::FormatRGBA8 })
+			{
+				std::shared_ptr<Image> Spans(new Image(TestImageData, Width, Height, Components, false, Format));
+				std::shared_ptr<Image> NoSpans = Spans->CopyImageSection(Width, Height);
+				Assert::IsTrue(Spans->HasRowSpans() && !NoSpans->HasRowSpans(), L"The spans weren't made when the image was loaded or kept after copying a section");
+
+				Image Test(22, 3, Format);
+				Image Expected(22, 3, Format);
+				Test.ChangeColor(std::make_shared<Pixel>(Pixel{ 0.0f, 0.0f, 1.0f, 0.5f }), true);
+				Expected.ChangeColor(std::make_shared<Pixel>(Pixel{ 0.0f, 0.0f, 1.0f, 0.5f }), true);
+				Test.CompositeImage(Spans, 5, 1);
+				Expected.CompositeImage(NoSpans, 5, 1);
+				Assert::IsTrue(Test == Expected, L"Compositing with the spans changed the image");
+				Assert::IsTrue(!Test.HasRowSpans(), L"The spans were kept after compositing onto the image");
+			}
+		}
+
+		TEST_METHOD(TrimTransparentMarginsTest)
+		{
+			//A green square with a transparent margin of 8 pixels on the left, 4 on top and 6 on the right and bottom
+			int Width = 24;
+			int Height = 20;
+			int Components = 4;
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components](), std::default_delete<unsigned char[]>());
+			for (int y = 4; y < 14; y++)
+			{
+				for (int x = 8; x < 18; x++)
+				{
+					TestImageData.get()[(y * Width + x) * Components + 1] = 255;
+					TestImageData.get()[(y * Width + x) * Components + 3] = x == 8 ? 128 : 255;
+				}
+			}
+
+			std::shared_ptr<Image> Untrimmed(new Image(TestImageData, Width, Height, Components));
+			std::shared_ptr<Image> Trimmed(new Image(TestImageData, Width, Height, Components));
+			Trimmed->TrimTransparentMargins();
+			Assert::IsTrue(Trimmed->GetWidth() == 10 && Trimmed->GetHeight() == 10 && Trimmed->GetTrimLeft() == 8 && Trimmed->GetTrimTop() == 4, L"The margins weren't trimmed");
+			Assert::IsTrue(Trimmed->GetUntrimmedWidth() == Width && Trimmed->GetUntrimmedHeight() == Height, L"The untrimmed size wasn't kept");
+
+			//Resizing the trimmed image should give what resizing the whole image gives once it is placed at its trim offset
+			Untrimmed->ResizeImageWidth(15);
+			Trimmed->ResizeImageWidth(15);
+			Assert::IsTrue(Trimmed->GetUntrimmedWidth() == Untrimmed->GetWidth() && Trimmed->GetUntrimmedHeight() == Untrimmed->GetHeight(), L"The trimmed image got a different size");
+
+			Image Test(Untrimmed->GetWidth(), Untrimmed->GetHeight());
+			Image Expected(Untrimmed->GetWidth(), Untrimmed->GetHeight());
+			Test.CompositeImage(Trimmed, Trimmed->GetTrimLeft(), Trimmed->GetTrimTop());
+			Expected.CompositeImage(Untrimmed);
+			bool Correct = true;
+			for (int i = 0; i < Test.GetWidth() * Test.GetHeight(); i++)
+			{
+				const Pixel& TestPixel = Test.GetData().get()[i];
+				const Pixel& ExpectedPixel = Expected.GetData().get()[i];
+				if (fabs(TestPixel.r - ExpectedPixel.r) > 1.5f / 255.0f || fabs(TestPixel.g - ExpectedPixel.g) > 1.5f / 255.0f ||
+					fabs(TestPixel.b - ExpectedPixel.b) > 1.5f / 255.0f || fabs(TestPixel.a - ExpectedPixel.a) > 1.5f / 255.0f)
+				{
+					Correct = false;
+				}
+			}
+			Assert::IsTrue(Correct, L"The resized trimmed image doesn't match the resized untrimmed image");
+		}
+
+		TEST_METHOD(TrimmedResizeToZeroTest)
+		{
+			//The same green square in a transparent margin, a size of 0 fails like it does for an untrimmed image and leaves the image as it was
+			int Width = 24;
+			int Height = 20;
+			int Components = 4;
+			std::shared_ptr<unsigned char> TestImageData(new unsigned char[Width * Height * Components](), std::default_delete<unsigned char[]>());
+			for (int y = 4; y < 14; y++)
+			{
+				for (int x = 8; x < 18; x++)
+				{
+					TestImageData.get()[(y * Width + x) * Components + 1] = 255;
+					TestImageData.get()[(y * Width + x) * Components + 3] = 255;
+				}
+			}
+
+			std::shared_ptr<Image> Trimmed(new Image(TestImageData, Width, Height, Components));
+			Trimmed->TrimTransparentMargins();
+			Trimmed->ResizeImage(40, 0);
+			Assert::IsTrue(Trimmed->GetWidth() == 10 && Trimmed->GetHeight() == 10 && Trimmed->GetUntrimmedWidth() == Width && Trimmed->GetUntrimmedHeight() == Height,
+						   L"Resizing to a height of 0 changed the image");
+
+			//A factor this small rounds both sides down to 0
+			Trimmed->ScaleImage(0.01f);
+			Assert::IsTrue(Trimmed->GetWidth() == 10 && Trimmed->GetHeight() == 10 && Trimmed->GetUntrimmedWidth() == Width && Trimmed->GetUntrimmedHeight() == Height,
+						   L"Scaling by a tiny factor changed the image");
+
+			//The smallest size that isn't empty still works
+			Trimmed->ResizeImage(1, 1);
+			Assert::IsTrue(Trimmed->GetUntrimmedWidth() == 1 && Trimmed->GetUntrimmedHeight() == 1 && Trimmed->GetWidth() <= 1 && Trimmed->GetHeight() <= 1,
+						   L"The image wasn't resized to a single pixel");
+		}
+	};
+
+	TEST_CLASS(PixelKernelsUnitTests)
+	{
+	public:
+		TEST_METHOD(CompositeRowTest)
+		{
+			//Blend the same row with the scalar kernel and the best one the CPU supports and check they stay within 1/255 of each other
+			const int Count = 37;
+			Pixel OtherRow[Count];
+			Pixel ScalarRow[Count];
+			Pixel VectorRow[Count];
+			for (int i = 0; i < Count; i++)
+			{
+				float OtherAlpha = (i % 4) / 3.0f;
+				float Alpha = (i % 6) / 5.0f;
+				OtherRow[i] = Pixel{ (i % 5) / 4.0f * OtherAlpha, (i % 3) / 2.0f * OtherAlpha, 0.5f * OtherAlpha, OtherAlpha };
+				ScalarRow[i] = Pixel{ 0.25f * Alpha, (i % 2) * Alpha, (i % 7) / 6.0f * Alpha, Alpha };
+				VectorRow[i] = ScalarRow[i];
+			}
+
+			KernelInstructionSet BestInstructionSet = PixelKernels::GetInstructionSet();
+			PixelKernels::SetInstructionSet(KernelInstructionSet::KernelScalar);
+			PixelKernels::CompositeRow(ScalarRow, OtherRow, Count);
+			PixelKernels::SetInstructionSet(BestInstructionSet);
+			PixelKernels::CompositeRow(VectorRow, OtherRow, Count);
+
+			bool Correct = true;
+			for (int i = 0; i < Count; i++)
+			{
+				if (fabs(ScalarRow[i].r - VectorRow[i].r) > 1.0f / 255.0f || fabs(ScalarRow[i].g - VectorRow[i].g) > 1.0f / 255.0f ||
+					fabs(ScalarRow[i].b - VectorRow[i].b) > 1.0f / 255.0f || fabs(ScalarRow[i].a - VectorRow[i].a) > 1.0f / 255.0f)
+				{
+					Correct = false;
+				}
+			}
+			Assert::IsTrue(Correct, L"The vectorized kernel didn't blend the same as the scalar kernel");
+		}
+	};
+
+	TEST_CLASS(AssetCacheUnitTests)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(SaveAnImage)
+		{
+			Image RedSquare(100, 100);
+			RedSquare.ChangeColor(std::shared_ptr<Pixel>(new Pixel{ 1.0f, 0.0f, 0.0f, 1.0f }), true);
+			RedSquare.SaveImage("../../UnitTestImages/CacheTest.png");
+			AssetCache::Clear();
+		}
+
+		TEST_METHOD(GetImageTest)
+		{
+			std::shared_ptr<Image> First = AssetCache::GetImage("../../UnitTestImages/CacheTest.png");
+			std::shared_ptr<Image> Second = AssetCache::GetImage("../../UnitTestImages/../UnitTestImages/CacheTest.png");
+			Image Original("../../UnitTestImages/CacheTest.png");
+			Assert::IsTrue(First == Second, L"The same file was decoded twice");
+			Assert::IsTrue(Original == First.get()[0], L"The cached image isn't the same as the file");
+			Assert::AreEqual(1LL, AssetCache::GetHits(), L"The second image didn't come from the cache");
+		}
+
+		TEST_METHOD(MemoryBudgetTest)
+		{
+			std::shared_ptr<Image> First = AssetCache::GetImage("../../UnitTestImages/CacheTest.png");
+			AssetCache::SetMemoryBudget(First->GetDataSize() - 1);
+			Assert::IsTrue(AssetCache::GetMemoryUsed() == 0, L"The image wasn't evicted when it went over the budget");
+
+			//The evicted image has to be loaded again but the one that is still being used stays valid
+			std::shared_ptr<Image> Second = AssetCache::GetImage("../../UnitTestImages/CacheTest.png");
+			Assert::IsTrue(First.get()[0] == Second.get()[0], L"The image changed after being evicted");
+			Assert::AreEqual(2LL, AssetCache::GetMisses(), L"The evicted image came from the cache");
+			AssetCache::SetMemoryBudget(static_cast<size_t>(512) * 1024 * 1024);
+		}
+
+		TEST_METHOD(ResizedImageTest)
+		{
+			std::shared_ptr<Image> Source = AssetCache::GetImage("../../UnitTestImages/CacheTest.png");
+			Assert::IsTrue(AssetCache::FindResizedImage(Source, 50, 0, true) == nullptr, L"Found an image that was never resized");
+
+			std::shared_ptr<Image> Resized(new Image());
+			Resized->CopyValue(Source);
+			Resized->ResizeImageWidth(50);
+			AssetCache::AddResizedImage(Source, 50, 0, true, Resized);
+			Assert::IsTrue(AssetCache::FindResizedImage(Source, 50, 0, true) == Resized, L"The resized image didn't come from the cache");
+			Assert::IsTrue(AssetCache::FindResizedImage(Source, 50, 0, false) == nullptr, L"The aspect ratio mode isn't part of the key");
+		}
+	};
+
+	TEST_CLASS(PngEncoderUnitTests)
+	{
+	public:
+		TEST_METHOD(EncodeTest)
+		{
+			//The image is bigger than a single chunk so the chunks have to be joined, every level and thread count has to give back the same pixels
+			int Width = 300;
+			int Height = 400;
+			std::shared_ptr<unsigned char> Data(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+			for (int i = 0; i < Width * Height * 4; i++)
+			{
+				Data.get()[i] = static_cast<unsigned char>((i % 4 == 3) ? 255 - (i / 4) % 200 : ((i / 4) % Width + (i * 7919) % 13));
+			}
+			Image Original(Data, Width, Height, 4, false, PixelFormat::FormatRGBA8);
+
+			for (int Level : { 0, 1, 3, 9 })
+			{
+				for (int Threads : { 1, 4 })
+				{
+					PngEncoder::SetCompressionLevel(Level);
+					PngEncoder::SetThreads(Threads);
+					Assert::IsTrue(PngEncoder::WriteFile("../../UnitTestImages/PngEncoderTest.png", Data.get(), Width, Height), L"The png couldn't be written");
+
+					Image Loaded("../../UnitTestImages/PngEncoderTest.png", PixelFormat::FormatRGBA8);
+					Assert::IsTrue(Original == Loaded, L"The encoded png doesn't have the same pixels");
+				}
+			}
+			PngEncoder::SetCompressionLevel(3);
+			PngEncoder::SetThreads(0);
+		}
+
+		TEST_METHOD(SharedThreadsTest)
+		{
+			int Width = 300;
+			int Height = 400;
+			std::shared_ptr<unsigned char> Data(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+			for (int i = 0; i < Width * Height * 4; i++)
+			{
+				Data.get()[i] = static_cast<unsigned char>((i / 4) % Width + (i * 7919) % 13);
+			}
+
+			//The level and threads given to Encode are used instead of the defaults
+			std::vector<unsigned char> Expected = PngEncoder::Encode(Data.get(), Width, Height, 4, 6, 1);
+			PngEncoder::SetCompressionLevel(1);
+			Assert::IsTrue(Expected == PngEncoder::Encode(Data.get(), Width, Height, 4, 6, 4), L"The level given to Encode wasn't used");
+			Assert::IsTrue(Expected != PngEncoder::Encode(Data.get(), Width, Height, 4), L"The default level wasn't used");
+			PngEncoder::SetCompressionLevel(3);
+
+			//Images encoded at the same time share the threads of the encoder and still give the same file
+			std::vector<std::vector<unsigned char>> Results(4);
+			std::vector<std::thread> Encoders;
+			for (int i = 0; i < 4; i++)
+			{
+				Encoders.push_back(std::thread([&, i]() { Results[i] = PngEncoder::Encode(Data.get(), Width, Height, 4, 6, 3); }));
+			}
+			for (std::thread& Encoder : Encoders)
+			{
+				Encoder.join();
+			}
+			for (const std::vector<unsigned char>& Result : Results)
+			{
+				Assert::IsTrue(Expected == Result, L"An image encoded at the same time as the others is different");
+			}
+		}
+
+		TEST_METHOD(CombineAdler32Test)
+		{
+			std::string Text = "The adler of the whole text has to be the same as the combined adlers of both halves";
+			const unsigned char* Bytes = reinterpret_cast<const unsigned char*>(Text.c_str());
+			unsigned int Whole = PngEncoder::Adler32(Bytes, Text.size());
+			unsigned int Combined = PngEncoder::CombineAdler32(PngEncoder::Adler32(Bytes, 30), PngEncoder::Adler32(Bytes + 30, Text.size() - 30), Text.size() - 30);
+			Assert::AreEqual(Whole, Combined, L"The combined adler is wrong");
+		}
+	};
+
+	TEST_CLASS(FrameWriterUnitTests)
+	{
+	public:
+		TEST_METHOD(ConvertFrameTest)
+		{
+			//A red frame with a transparent bottom row, the odd size makes the last chroma row and column come from fewer pixels
+			int Width = 37;
+			int Height = 5;
+			std::shared_ptr<unsigned char> Data(new unsigned char[Width * Height * 4](), std::default_delete<unsigned char[]>());
+			for (int i = 0; i < Width * (Height - 1); i++)
+			{
+				Data.get()[i * 4] = 255;
+				Data.get()[i * 4 + 3] = 255;
+			}
+			std::shared_ptr<Image> Frame(new Image(Data, Width, Height, 4, false, PixelFormat::FormatRGBA8));
+
+			std::shared_ptr<unsigned char> Raw = FrameWriter::ConvertFrame(Frame, FrameFormat::FrameRaw, Width, Height);
+			Assert::IsTrue(memcmp(Raw.get(), Data.get(), Width * Height * 4) == 0, L"The raw frame isn't the same as the pixels of the image");
+
+			//The transparent row is put on black and every instruction set has to give the same frame
+			KernelInstructionSet BestInstructionSet = PixelKernels::GetInstructionSet();
+			PixelKernels::SetInstructionSet(KernelInstructionSet::KernelScalar);
+			std::shared_ptr<unsigned char> ScalarFrame = FrameWriter::ConvertFrame(Frame, FrameFormat::FrameY4M, Width, Height);
+			PixelKernels::SetInstructionSet(BestInstructionSet);
+			std::shared_ptr<unsigned char> VectorFrame = FrameWriter::ConvertFrame(Frame, FrameFormat::FrameY4M, Width, Height);
+
+			size_t FrameSize = FrameWriter::GetFrameSize(FrameFormat::FrameY4M, Width, Height);
+			Assert::AreEqual(static_cast<size_t>(Width * Height + 19 * 3 * 2), FrameSize, L"The YUV420 frame has the wrong size");
+			Assert::IsTrue(memcmp(ScalarFrame.get(), VectorFrame.get(), FrameSize) == 0, L"The vectorized conversion didn't give the same frame as the scalar one");
+
+			const unsigned char* UPlane = VectorFrame.get() + Width * Height;
+			const unsigned char* VPlane = UPlane + 19 * 3;
+			Assert::AreEqual(82, static_cast<int>(VectorFrame.get()[0]), L"The luma of red is wrong");
+			Assert::AreEqual(16, static_cast<int>(VectorFrame.get()[Width * (Height - 1)]), L"The transparent pixels aren't black");
+			Assert::AreEqual(90, static_cast<int>(UPlane[18]), L"The U of red is wrong");
+			Assert::AreEqual(240, static_cast<int>(VPlane[0]), L"The V of red is wrong");
+			Assert::AreEqual(128, static_cast<int>(VPlane[19 * 2]), L"The chroma of black isn't neutral");
+		}
+
+		TEST_METHOD(ConvertFrameInstructionSetTest)
+		{
+			//Every pixel is different so a kernel that puts the samples in the wrong order can't give the same frame, the width leaves some pixels for the smaller kernels
+			int Width = 53;
+			int Height = 4;
+			std::shared_ptr<unsigned char> Data(new unsigned char[Width * Height * 4], std::default_delete<unsigned char[]>());
+			for (int i = 0; i < Width * Height * 4; i++)
+			{
+				Data.get()[i] = static_cast<unsigned char>(i * 37 + i / 4 * 11);
+			}
+			std::shared_ptr<Image> Frame(new Image(Data, Width, Height, 4, false, PixelFormat::FormatRGBA8));
+
+			KernelInstructionSet BestInstructionSet = PixelKernels::GetInstructionSet();
+			PixelKernels::SetInstructionSet(KernelInstructionSet::KernelScalar);
+			std::shared_ptr<unsigned char> ScalarFrame = FrameWriter::ConvertFrame(Frame, FrameFormat::FrameY4M, Width, Height);
+			size_t FrameSize = FrameWriter::GetFrameSize(FrameFormat::FrameY4M, Width, Height);
+			for (KernelInstructionSet InstructionSet : { KernelInstructionSet::KernelSSE41, KernelInstructionSet::KernelAVX2 })
+			{
+				PixelKernels::SetInstructionSet(InstructionSet);
+				std::shared_ptr<unsigned char> VectorFrame = FrameWriter::ConvertFrame(Frame, FrameFormat::FrameY4M, Width, Height);
+				Assert::IsTrue(memcmp(ScalarFrame.get(), VectorFrame.get(), FrameSize) == 0, L"An instruction set didn't give the same frame as the scalar one");
+			}
+			PixelKernels::SetInstructionSet(BestInstructionSet);
+		}
+	};
+
+	TEST_CLASS(MappedFileUnitTests)
+	{
+	public:
+		TEST_METHOD(MapFileTest)
+		{
+			std::string Contents = "The mapping has to give back exactly what was written";
+			{
+				std::ofstream File("../../UnitTestImages/Mapped.txt", std::ios::binary);
+				File << Contents;
+			}
+
+			MappedFile File("../../UnitTestImages/Mapped.txt");
+			Assert::IsTrue(File.IsOpen(), L"The file didn't open");
+			Assert::IsTrue(File.IsMapped(), L"A normal file should be mapped and not read into a buffer");
+			Assert::AreEqual(Contents.size(), File.GetSize(), L"The mapping has the wrong size");
+			Assert::IsTrue(memcmp(File.GetData(), Contents.data(), Contents.size()) == 0, L"The mapped data isn't the same as the file");
+
+			//A file that doesn't exist doesn't open and an empty file opens without being mapped
+			MappedFile Missing("../../UnitTestImages/DoesNotExist.txt");
+			Assert::IsFalse(Missing.IsOpen(), L"A missing file shouldn't open");
+
+			{
+				std::ofstream Empty("../../UnitTestImages/Empty.txt", std::ios::binary);
+			}
+			MappedFile Empty("../../UnitTestImages/Empty.txt");
+			Assert::IsTrue(Empty.IsOpen(), L"The empty file didn't open");
+			Assert::IsFalse(Empty.IsMapped(), L"An empty file can't be mapped");
+			Assert::AreEqual(static_cast<size_t>(0), Empty.GetSize(), L"The empty file has data");
+		}
+	};
+
+	TEST_CLASS(BoundedQueueUnitTests)
+	{
+	public:
+		TEST_METHOD(PushPopTest)
+		{
+			//The producer can only get 2 items ahead so it has to wait for the consumer, which gets them back in the same order
+			BoundedQueue<int> Queue(2);
+			std::thread Producer([&Queue]()
+				{
+					for (int i = 0; i < 100; i++)
+					{
+						Queue.Push(i);
+					}
+					Queue.Close();
+				});
+
+			int Item = 0;
+			int Expected = 0;
+			while (Queue.Pop(Item))
+			{
+				Assert::AreEqual(Expected++, Item, L"The items didn't come out in the order they were pushed");
+			}
+			Producer.join();
+
+			Assert::AreEqual(100, Expected, L"Not every item came out of the queue");
+			Assert::IsFalse(Queue.Push(100), L"An item could be pushed after the queue was closed");
+		}
+	};
+
+	TEST_CLASS(ProfilerUnitTests)
+	{
+	public:
+		TEST_METHOD(FrameReportTest)
+		{
+			Profiler::SetEnabled(true);
+			Profiler::Reset();
+
+			Profiler::BeginFrame("Frame");
+			{
+				ScopedTimer Timer(ProfilerStage::StageComposite);
+				Image Background(10, 10);
+				Background.CompositeImage(std::shared_ptr<Image>(new Image(4, 4)), 8, 8);
+			}
+			Profiler::EndFrame();
+			Profiler::SetEnabled(false);
+
+			//The timer around the composite and the one inside of it are both counted and only the pixels inside the background are composited
+			nlohmann::json Report = Profiler::MakeReport();
+			Assert::AreEqual(1, Report.at("FrameCount").get<int>(), L"The frame wasn't added to the report");
+			Assert::AreEqual(2, Report.at("Stages").at("Composite").at("Calls").get<int>(), L"The composite stage wasn't timed");
+			Assert::AreEqual(4, Report.at("Frames")[0].at("Counters").at("PixelsComposited").get<int>(), L"The composited pixels weren't counted");
+		}
+
+		TEST_METHOD(FrameSpreadTest)
+		{
+			Profiler::SetEnabled(true);
+			Profiler::Reset();
+
+			//Frame i spends i + 1 milliseconds compositing
+			const int FrameCount = static_cast<int>(Profiler::MaximumFrameReports) + 10;
+			for (int i = 0; i < FrameCount; i++)
+			{
+				Profiler::BeginFrame("Frame");
+				Profiler::AddStageTime(ProfilerStage::StageComposite, (i + 1) * 1000000LL);
+				Profiler::EndFrame();
+			}
+			Profiler::SetEnabled(false);
+
+			//Every frame is counted but only the first ones are kept on their own
+			nlohmann::json Report = Profiler::MakeReport();
+			Assert::AreEqual(FrameCount, Report.at("FrameCount").get<int>(), L"Not every frame was counted");
+			Assert::AreEqual(Profiler::MaximumFrameReports, Report.at("Frames").size(), L"The frame list wasn't capped");
+			nlohmann::json Composite = Report.at("FrameStages").at("Composite");
+			Assert::AreEqual(1.0, Composite.at("MinimumMilliseconds").get<double>(), L"The shortest frame is wrong");
+			Assert::AreEqual(static_cast<double>(FrameCount), Composite.at("MaximumMilliseconds").get<double>(), L"The longest frame is wrong");
+			Assert::AreEqual((FrameCount + 1) / 2.0, Composite.at("AverageMilliseconds").get<double>(), L"The average frame is wrong");
+			Profiler::Reset();
+		}
 	};
 
 	TEST_CLASS(FontUnitTests)
@@ -333,6 +828,155 @@ namespace VideoImageGeneratorUnitTests
 			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
 			Assert::AreEqual(Text.GetWidth(), TestFont->GetStringLength("Paradise Lost", 128), L"The images aren't of the same length");
 		}
+
+		TEST_METHOD(GlyphCacheTest)
+		{
+			Image Text("../../UnitTestImages/ExpectedResults/ExpectedFontTextImage.png");
+			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
+			TestFont->GetTextImage("Paradise Lost", 128);
+			long long Misses = TestFont->GetGlyphCacheMisses();
+
+			//The second time every character should come from the cache and give the same image
+			Assert::IsTrue(Text == TestFont->GetTextImage("Paradise Lost", 128).get()[0], L"The images weren't the same");
+			Assert::AreEqual(Misses, TestFont->GetGlyphCacheMisses(), L"A character was rasterized twice");
+			Assert::AreEqual(13LL + 13LL - Misses, TestFont->GetGlyphCacheHits(), L"Not every character came from the cache");
+		}
+
+		TEST_METHOD(ShapeTextTest)
+		{
+			Image Text("../../UnitTestImages/ExpectedResults/ExpectedFontTextImage.png");
+			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
+			ShapedText Shaped = TestFont->ShapeText("Paradise Lost", 128);
+			Assert::AreEqual(Text.GetWidth(), Shaped.Width, L"The shaped text doesn't have the width of the image");
+			Assert::AreEqual(static_cast<size_t>(13), Shaped.Glyphs.size(), L"Not every character was shaped");
+			Assert::AreEqual(0, Shaped.Glyphs[0].XOffset, L"The first character doesn't start at the left");
+			Assert::AreEqual(static_cast<int>('P'), Shaped.Glyphs[0].Codepoint, L"The first character is wrong");
+
+			//Every character has a width in this string so each one starts after the one before it
+			for (size_t i = 1; i < Shaped.Glyphs.size(); i++)
+			{
+				Assert::IsTrue(Shaped.Glyphs[i].XOffset > Shaped.Glyphs[i - 1].XOffset, L"The characters don't go from left to right");
+			}
+
+			//A font that can't be loaded measures every string as empty instead of reading a font that isn't there
+			std::shared_ptr<Font> MissingFont(new Font("../../UnitTestImages/DoesNotExist.ttf"));
+			Assert::AreEqual(0, MissingFont->GetStringLength("Paradise Lost", 128), L"A missing font gave text a width");
+		}
+
+		TEST_METHOD(UTF8TextTest)
+		{
+			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
+
+			//A 2 byte, a 3 byte and a 4 byte character, a lone continuation byte and a sequence that ends early
+			ShapedText Shaped = TestFont->ShapeText("\xC3\xA9" "\xE2\x82\xAC" "\xF0\x9F\x98\x80" "\x80" "\xC3" "a", 64);
+			int Expected[]{ 0xE9, 0x20AC, 0x1F600, 0xFFFD, 0xFFFD, 'a' };
+			Assert::AreEqual(static_cast<size_t>(6), Shaped.Glyphs.size(), L"The text wasn't decoded into the right number of characters");
+			for (int i = 0; i < 6; i++)
+			{
+				Assert::AreEqual(Expected[i], Shaped.Glyphs[i].Codepoint, L"A character was decoded wrong");
+			}
+
+			//The characters past Latin-1 get their metrics when they are first used and the image has the width of the text
+			std::string Name = "Jos\xC3\xA9 \xC5\x81\xC3\xB3" "d\xC5\xBA \xE2\x82\xAC";
+			ShapedText ShapedName = TestFont->ShapeText(Name, 64);
+			for (size_t i = 1; i < ShapedName.Glyphs.size(); i++)
+			{
+				Assert::IsTrue(ShapedName.Glyphs[i].XOffset > ShapedName.Glyphs[i - 1].XOffset, L"A character didn't get an advance");
+			}
+			Assert::AreEqual(ShapedName.Width, TestFont->GetTextImage(Name, 64)->GetWidth(), L"The image doesn't have the width of the text");
+
+			//A single character is decoded the same way instead of its first byte being used as the codepoint
+			std::shared_ptr<GlyphBitmap> Glyph = TestFont->GetGlyphBitmap(0xE9, 64);
+			std::shared_ptr<Image> Character = TestFont->GetCharacterImage("\xC3\xA9", 64);
+			Assert::AreEqual(Glyph->Width, Character->GetWidth(), L"The character image isn't of the decoded character");
+			Assert::AreEqual(Glyph->Height, Character->GetHeight(), L"The character image isn't of the decoded character");
+		}
+
+		TEST_METHOD(SignedDistanceFieldTest)
+		{
+			std::shared_ptr<Font> RasterizedFont(new Font("C:/Windows/Fonts/arial.ttf"));
+			std::shared_ptr<Font> FieldFont(new Font("C:/Windows/Fonts/arial.ttf", true));
+			Assert::IsTrue(FieldFont->IsSignedDistanceField() && !RasterizedFont->IsSignedDistanceField(), L"The fonts are in the wrong mode");
+
+			//The text is laid out the same way and only the edges are a little different, the alpha of the whole image is compared
+			std::shared_ptr<Image> Rasterized = RasterizedFont->GetTextImage("Paradise Lost", 64);
+			std::shared_ptr<Image> Field = FieldFont->GetTextImage("Paradise Lost", 64);
+			Assert::AreEqual(Rasterized->GetWidth(), Field->GetWidth(), L"The text doesn't have the same width");
+			float Alpha = 0.0f;
+			float Difference = 0.0f;
+			for (int i = 0; i < Rasterized->GetWidth() * Rasterized->GetHeight(); i++)
+			{
+				Alpha += Rasterized->GetData().get()[i].a;
+				Difference += fabs(Rasterized->GetData().get()[i].a - Field->GetData().get()[i].a);
+			}
+			Assert::IsTrue(Difference < Alpha * 0.1f, L"The text made from the fields is too different from the rasterized text");
+
+			//Every character only has one field no matter how many pixel heights it is used at
+			long long Misses = FieldFont->GetGlyphCacheMisses();
+			FieldFont->GetTextImage("Paradise Lost", 16);
+			FieldFont->GetTextImage("Paradise Lost", 128);
+			Assert::AreEqual(Misses, FieldFont->GetGlyphCacheMisses(), L"A field was made twice");
+		}
+
+		TEST_METHOD(TextRunCacheTest)
+		{
+			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
+			std::shared_ptr<Pixel> Red(new Pixel{ 1.0f, 0.0f, 0.0f, 1.0f });
+
+			//The run has to be the same as the text image colored and converted by hand
+			std::shared_ptr<Image> Expected = TestFont->GetTextImage("Paradise Lost", 64);
+			Expected->ChangeColor(Red);
+			Expected->ConvertFormat(PixelFormat::FormatRGBA8);
+			std::shared_ptr<Image> Run = TestFont->GetTextRunImage("Paradise Lost", 64, Red, PixelFormat::FormatRGBA8);
+			Assert::IsTrue(*Run == *Expected, L"The run isn't the same as the colored text image");
+			Assert::AreEqual(TestFont->GetStringLength("Paradise Lost", 64), Run->GetWidth(), L"The run doesn't have the width of the text");
+
+			//The same run is shared, a different color or format is a different run
+			Assert::IsTrue(Run == TestFont->GetTextRunImage("Paradise Lost", 64, Red, PixelFormat::FormatRGBA8), L"The run wasn't taken from the cache");
+			Assert::IsTrue(Run != TestFont->GetTextRunImage("Paradise Lost", 64, Red, PixelFormat::FormatFloat), L"The format isn't part of the key");
+			Assert::IsTrue(Run != TestFont->GetTextRunImage("Paradise Lost", 64, std::make_shared<Pixel>(Pixel{ 1.0f, 0.0f, 0.0f, 0.5f }), PixelFormat::FormatRGBA8), L"The color isn't part of the key");
+			Assert::AreEqual(1LL, TestFont->GetTextRunHits(), L"The hits are wrong");
+			Assert::AreEqual(3LL, TestFont->GetTextRunMisses(), L"The misses are wrong");
+
+			//Without any budget every run is evicted but the block using it can still draw it
+			TestFont->SetTextRunBudget(0);
+			Assert::AreEqual(static_cast<size_t>(0), TestFont->GetTextRunMemoryUsed(), L"The runs weren't evicted");
+			Assert::IsTrue(*Run == *Expected, L"The evicted run was changed");
+		}
+
+		TEST_METHOD(DrawTextTest)
+		{
+			std::shared_ptr<Font> TestFont(new Font("C:/Windows/Fonts/arial.ttf"));
+			std::shared_ptr<Pixel> Red(new Pixel{ 1.0f, 0.0f, 0.0f, 1.0f });
+
+			//Drawing the text straight onto an image has to give the same image as compositing the run, the last characters go past the edge
+			std::shared_ptr<Image> Expected(new Image{ 300, 100 });
+			Expected->ChangeColor(std::make_shared<Pixel>(Pixel{ 0.0f, 0.0f, 1.0f, 1.0f }), true);
+			std::shared_ptr<Image> Drawn(new Image{ 300, 100 });
+			Drawn->CopyValue(Expected);
+			Expected->CompositeImage(TestFont->GetTextRunImage("Paradise Lost", 64, Red, PixelFormat::FormatFloat), 20, 10);
+			TestFont->DrawShapedText(Drawn, TestFont->ShapeText("Paradise Lost", 64), 64, *Red, 20, 10);
+			float Difference = 0.0f;
+			for (int i = 0; i < Expected->GetWidth() * Expected->GetHeight(); i++)
+			{
+				Difference = fmaxf(Difference, fabs(Expected->GetData().get()[i].r - Drawn->GetData().get()[i].r));
+				Difference = fmaxf(Difference, fabs(Expected->GetData().get()[i].b - Drawn->GetData().get()[i].b));
+			}
+			Assert::IsTrue(Difference < 0.001f, L"The drawn text isn't the same as the composited run");
+
+			//In RGBA8 the drawn text is rounded the same way as the run so the first image with some text is the same as the ones after it
+			std::shared_ptr<Image> PackedExpected(new Image{ 300, 100, PixelFormat::FormatRGBA8 });
+			PackedExpected->ChangeColor(std::make_shared<Pixel>(Pixel{ 0.0f, 0.0f, 1.0f, 1.0f }), true);
+			std::shared_ptr<Image> PackedDrawn(new Image{ 300, 100, PixelFormat::FormatRGBA8 });
+			PackedDrawn->CopyValue(PackedExpected);
+			PackedExpected->CompositeImage(TestFont->GetTextRunImage("Paradise Lost", 64, Red, PixelFormat::FormatRGBA8), 20, 10);
+			TestFont->DrawShapedText(PackedDrawn, TestFont->ShapeText("Paradise Lost", 64), 64, *Red, 20, 10);
+			Assert::IsTrue(*PackedExpected == *PackedDrawn, L"The drawn text isn't the same as the composited run in RGBA8");
+
+			//A run that is only asked for once isn't rendered, the second time it is
+			Assert::IsTrue(TestFont->GetTextRunImage("Paradise Regained", 64, Red, PixelFormat::FormatFloat, true) == nullptr, L"The run was rendered the first time");
+			Assert::IsTrue(TestFont->GetTextRunImage("Paradise Regained", 64, Red, PixelFormat::FormatFloat, true) != nullptr, L"The run wasn't rendered the second time");
+		}
 	};
 
 	TEST_CLASS(layoutUnitTests)
@@ -424,5 +1068,107 @@ namespace VideoImageGeneratorUnitTests
 			Image LayoutGenerated("../../UnitTestImages/OverrideTest.png");
 			Assert::IsTrue(OriginalOverride == LayoutGeneratedOverride && Original == LayoutGenerated, L"The layout didn't composite the text blocks properly");
 		}
+
+		TEST_METHOD(ThreadedLayoutTest)
+		{
+			std::ifstream File("../../UnitTestImages/ExpectedResults/LayoutUnitTests.json");
+			nlohmann::json Data = nlohmann::json::parse(File);
+
+			//Both images of the potential layout test are rendered at the same time and should be the same as when they are rendered one after the other
+			nlohmann::json LayoutData = Data.at("PotentialLayoutTest");
+			LayoutData["Layout"]["Threads"] = 2;
+			std::shared_ptr<Layout> Test(new Layout(LayoutData));
+
+			Image OriginalLeft("../../UnitTestImages/ExpectedResults/ExpectedSnapBlockTest.png");
+			Image LayoutGeneratedLeft("../../UnitTestImages/PotentialLayoutTestLeft.png");
+
+			Image OriginalRight("../../UnitTestImages/ExpectedResults/ExpectedPotentialLayoutTestRight.png");
+			Image LayoutGeneratedRight("../../UnitTestImages/PotentialLayoutTestRight.png");
+			Assert::IsTrue(OriginalLeft == LayoutGeneratedLeft && OriginalRight == LayoutGeneratedRight, L"The threaded layout didn't give the same images");
+		}
+
+		TEST_METHOD(StreamedLayoutTest)
+		{
+			std::ifstream File("../../UnitTestImages/ExpectedResults/LayoutUnitTests.json");
+			nlohmann::json Data = nlohmann::json::parse(File);
+
+			//A batch of 1 renders every image as soon as it has been read, dump sorts the keys so the Layout is put in front by hand
+			LayoutSettings Settings;
+			Settings.BatchSize = 1;
+			nlohmann::json LayoutData = Data.at("PotentialLayoutTest");
+			std::stringstream Stream("{\"Layout\": " + LayoutData.at("Layout").dump() + ", \"Images\": " + LayoutData.at("Images").dump() + "}");
+			std::shared_ptr<Layout> Test(new Layout(Stream, Settings));
+			Assert::IsTrue(Test->IsValid(), L"The streamed layout wasn't valid");
+
+			Image OriginalLeft("../../UnitTestImages/ExpectedResults/ExpectedSnapBlockTest.png");
+			Image LayoutGeneratedLeft("../../UnitTestImages/PotentialLayoutTestLeft.png");
+
+			Image OriginalRight("../../UnitTestImages/ExpectedResults/ExpectedPotentialLayoutTestRight.png");
+			Image LayoutGeneratedRight("../../UnitTestImages/PotentialLayoutTestRight.png");
+			Assert::IsTrue(OriginalLeft == LayoutGeneratedLeft && OriginalRight == LayoutGeneratedRight, L"The streamed layout didn't give the same images");
+
+			std::stringstream BrokenStream("{\"Layout\": {");
+			std::shared_ptr<Layout> BrokenTest(new Layout(BrokenStream, Settings));
+			Assert::IsFalse(BrokenTest->IsValid(), L"A broken json was seen as valid");
+		}
+
+		TEST_METHOD(StaticLayerTest)
+		{
+			std::ifstream File("../../UnitTestImages/ExpectedResults/LayoutUnitTests.json");
+			nlohmann::json Data = nlohmann::json::parse(File);
+
+			//The BlueCenter and the GreenBar linked to it are the same in both images so they go into the static layer, the last GreenBar is moved in the second image
+			nlohmann::json LayoutData = Data.at("ImageBlockTest");
+			nlohmann::json MovedImage = LayoutData.at("Images")[0];
+			MovedImage["Filename"] = "StaticLayerTestMoved";
+			MovedImage["Data"][1]["Override"] = { {"WidthOffset", 20} };
+			LayoutData["Images"][0]["Filename"] = "StaticLayerTest";
+			LayoutData["Images"].push_back(MovedImage);
+
+			LayoutSettings Settings;
+			Settings.bStaticLayer = false;
+			std::shared_ptr<Layout> Expected(new Layout(LayoutData, Settings));
+			Image Original("../../UnitTestImages/StaticLayerTest.png");
+			Image OriginalMoved("../../UnitTestImages/StaticLayerTestMoved.png");
+
+			Settings.bStaticLayer = true;
+			std::shared_ptr<Layout> Test(new Layout(LayoutData, Settings));
+			Image LayoutGenerated("../../UnitTestImages/StaticLayerTest.png");
+			Image LayoutGeneratedMoved("../../UnitTestImages/StaticLayerTestMoved.png");
+
+			Image ImageBlockOriginal("../../UnitTestImages/ExpectedResults/ExpectedImageBlockTest.png");
+			Assert::IsTrue(ImageBlockOriginal == LayoutGenerated, L"The static layer changed the image");
+			Assert::IsTrue(Original == LayoutGenerated && OriginalMoved == LayoutGeneratedMoved, L"The images with a static layer aren't the same as without it");
+		}
+
+		TEST_METHOD(PackedStaticLayerTest)
+		{
+			//The First and Second text overlap and are the same in both images, in RGBA8 every blend is rounded so they have to be drawn in the same order
+			//with and without the static layer. Nothing is cropped so the blocks are drawn straight onto the background
+			nlohmann::json LayoutData = nlohmann::json::parse(R"({
+				"Layout": {"SaveFilePath": "..\\..\\UnitTestImages\\", "Width": 100, "Height": 100, "Background Image": "..\\..\\UnitTestImages\\Red.png",
+					"Font": "C:/Windows/Fonts/arial.ttf", "PixelFormat": 1, "Blocks": [
+					{"Type": "TextBlock", "Name": "First", "WidthOffset": 10, "HeightOffset": 10},
+					{"Type": "TextBlock", "Name": "Second", "WidthOffset": 14, "HeightOffset": 14},
+					{"Type": "TextBlock", "Name": "Changing", "WidthOffset": 10, "HeightOffset": 60}]},
+				"Images": [
+					{"Filename": "PackedStaticLayerTest", "Data": [{"Name": "First", "Text": "WAVE", "PixelHeight": 40, "ColorR": 0.5, "ColorG": 0.4},
+						{"Name": "Second", "Text": "VAW", "PixelHeight": 40, "ColorR": 0.2, "ColorB": 0.6}, {"Name": "Changing", "Text": "ABC", "PixelHeight": 30}]},
+					{"Filename": "PackedStaticLayerTestChanged", "Data": [{"Name": "First", "Text": "WAVE", "PixelHeight": 40, "ColorR": 0.5, "ColorG": 0.4},
+						{"Name": "Second", "Text": "VAW", "PixelHeight": 40, "ColorR": 0.2, "ColorB": 0.6}, {"Name": "Changing", "Text": "XYZ", "PixelHeight": 30}]}]
+			})");
+
+			LayoutSettings Settings;
+			Settings.bStaticLayer = false;
+			std::shared_ptr<Layout> Expected(new Layout(LayoutData, Settings));
+			Image Original("../../UnitTestImages/PackedStaticLayerTest.png");
+			Image OriginalChanged("../../UnitTestImages/PackedStaticLayerTestChanged.png");
+
+			Settings.bStaticLayer = true;
+			std::shared_ptr<Layout> Test(new Layout(LayoutData, Settings));
+			Image LayoutGenerated("../../UnitTestImages/PackedStaticLayerTest.png");
+			Image LayoutGeneratedChanged("../../UnitTestImages/PackedStaticLayerTestChanged.png");
+			Assert::IsTrue(Original == LayoutGenerated && OriginalChanged == LayoutGeneratedChanged, L"The RGBA8 images with a static layer aren't the same as without it");
+		}
 	};
 }